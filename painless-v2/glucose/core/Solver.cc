@@ -1342,7 +1342,8 @@ lbool Solver::search(int nof_conflicts) {
       CRef confl = propagate();
 
       if (confl != CRef_Undef) {
-         if(parallelJobIsFinished())
+         // An interrupt is handled at the next conflict, not at the restart
+         if(parallelJobIsFinished() || !withinBudget())
             return l_Undef;
 
 
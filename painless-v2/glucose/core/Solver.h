@@ -245,6 +245,7 @@ public:
     //
     uint64_t nbRemovedClauses,nbRemovedUnaryWatchedClauses, nbReducedClauses,nbDL2,nbBin,nbUn,nbReduceDB,solves, starts, decisions, rnd_decisions, propagations, conflicts,conflictsRestarts,nbstopsrestarts,nbstopsrestartssame,lastblockatrestart;
     uint64_t dec_vars, clauses_literals, learnts_literals, max_literals, tot_literals;
+    float sumLBD; // used to compute the global average of LBD. Restarts...
 
     bool        remove_satisfied; // Indicates whether possibly inefficient linear scan for satisfied clauses should be performed in 'simplify'.
     std::vector<int>            flipActivity;     // Number of flips for each variable.
@@ -330,7 +331,6 @@ protected:
     
     // Used for restart strategies
     bqueue<unsigned int> trailQueue; // Bounded queues for restarts.
-    float sumLBD; // used to compute the global average of LBD. Restarts...
     int sumAssumptions;
     CRef lastLearntClause;
 
@@ -227,6 +227,12 @@ void ParallelSolver::reduceDB() {
 
 
 void ParallelSolver::parallelImportClauseDuringConflictAnalysis(Clause &c,CRef confl) {
+    if (c.wasImported() && c.importedFrom() != 0) { // First use of an imported clause
+        if (importedClauseUsed != NULL)
+            importedClauseUsed(issuer, c.importedFrom());
+        c.setImportedFrom(0);
+    }
+
     if (dontExportDirectReusedClauses && (confl == lastLearntClause) && (c.getExported() < 2)) { // Experimental stuff
         c.setExported(2);
         nbNotExportedBecauseDirectlyReused++;
@@ -315,8 +321,6 @@ bool ParallelSolver::parallelImportClauses() {
     while (importClause(issuer, &importedFromThread, importedClause)) {
         assert(importedFromThread >= 0);
 
-        assert(importedFromThread != thn);
-
         if (importedClause.size() == 0)
             return true;
 
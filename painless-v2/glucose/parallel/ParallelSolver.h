@@ -77,6 +77,7 @@ namespace Glucose
       void (* exportClause)(void *, Clause &);
       Lit  (* importUnary) (void *);
       bool (* importClause)(void *, int *, vec<Lit> &);
+      void (* importedClauseUsed)(void *, int) = NULL; // first use of a clause imported from a non-zero origin
 
       void * issuer;
 
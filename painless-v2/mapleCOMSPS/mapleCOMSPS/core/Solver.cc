@@ -21,6 +21,7 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 **************************************************************************************************/
 
 #include <math.h>
+#include <algorithm>
 
 #include "../mtl/Sort.h"
 #include "../core/Solver.h"
@@ -78,6 +79,7 @@ Solver::Solver() :
   , ccmin_mode       (opt_ccmin_mode)
   , phase_saving     (opt_phase_saving)
   , rnd_pol          (false)
+  , assumps_only     (false)
   , rnd_init_act     (opt_rnd_init_act)
   , garbage_frac     (opt_garbage_frac)
   , restart_first    (opt_restart_first)
@@ -97,6 +99,9 @@ Solver::Solver() :
   , solves(0), starts(0), decisions(0), rnd_decisions(0), propagations(0), conflicts(0), conflicts_VSIDS(0)
   , dec_vars(0), clauses_literals(0), learnts_literals(0), max_literals(0), tot_literals(0)
 
+  , useFlip            (false)
+  , usePR              (false)
+
   , ok                 (true)
   , cla_inc            (1)
   , var_inc            (1)
@@ -143,6 +148,7 @@ Solver::Solver(const Solver &s) :
   , ccmin_mode       (s.ccmin_mode)
   , phase_saving     (s.phase_saving)
   , rnd_pol          (s.rnd_pol)
+  , assumps_only     (s.assumps_only)
   , rnd_init_act     (s.rnd_init_act)
   , garbage_frac     (s.garbage_frac)
   , restart_first    (s.restart_first)
@@ -159,6 +165,12 @@ Solver::Solver(const Solver &s) :
   , dec_vars(s.dec_vars), clauses_literals(s.clauses_literals)
   , learnts_literals(s.learnts_literals), max_literals(s.max_literals), tot_literals(s.tot_literals)
 
+  , useFlip(s.useFlip)
+  , usePR(s.usePR)
+  , flipActivity(s.flipActivity)
+  , nbPropagations(s.nbPropagations)
+  , nbDecisionVar(s.nbDecisionVar)
+
   , ok(true)
   , cla_inc(s.cla_inc)
   , var_inc(s.var_inc)
@@ -258,6 +270,11 @@ Var Solver::newVar(bool sign, bool dvar)
     conflicted.push(0);
     almost_conflicted.push(0);
 
+    if (useFlip) flipActivity.push_back(0);
+    if (usePR){
+        nbPropagations.push_back(0);
+        nbDecisionVar .push_back(0); }
+
     seen     .push(0);
     seen2    .push(0);
     polarity .push(sign);
@@ -352,7 +369,8 @@ bool Solver::importClauses() {
         return true;
     int lbd, k, l;
     bool alreadySat;
-    while (cbkImportClause(issuer, &lbd, importedClause)) {
+    int origin;
+    while (cbkImportClause(issuer, &lbd, &origin, importedClause)) {
         alreadySat = false;
         // Simplify clause before add
         for (k = l = 0; k < importedClause.size(); k++) {
@@ -378,6 +396,7 @@ bool Solver::importClauses() {
             CRef cr = ca.alloc(importedClause, true);
             lbd = importedClause.size();
             ca[cr].set_lbd(lbd);
+            ca[cr].origin(origin);
             if (lbd <= core_lbd_cut) {
                 learnts_core.push(cr);
                 ca[cr].mark(CORE);
@@ -484,8 +503,9 @@ void Solver::cancelUntil(int level) {
 
             assigns [x] = l_Undef;
 
-            if (phase_saving > 1 || (phase_saving == 1) && c > trail_lim.last())
-                polarity[x] = sign(trail[c]);
+            if (phase_saving > 1 || (phase_saving == 1) && c > trail_lim.last()){
+                if (useFlip && sign(trail[c]) != polarity[x]) flipActivity[x]++;
+                polarity[x] = sign(trail[c]); }
             insertVarOrder(x); }
         qhead = trail_lim[level];
         trail.shrink(trail.size() - trail_lim[level]);
@@ -518,6 +538,50 @@ Lit Solver::pickBranchLit()
     return mkLit(next, polarity[next]);
 }
 
+Lit Solver::pickBranchLitUsingActivity()
+{
+    const vec<double>& activity = VSIDS ? activity_VSIDS : activity_CHB;
+    Var next = var_Undef;
+
+    for (Var v = 0; v < nVars(); v++)
+        if (decision[v] && value(v) == l_Undef && (next == var_Undef || activity[v] > activity[next]))
+            next = v;
+
+    return next == var_Undef ? lit_Undef : mkLit(next, polarity[next]);
+}
+
+Lit Solver::pickBranchLitUsingFlipActivity()
+{
+    assert(useFlip);
+    Var next = var_Undef;
+
+    for (Var v = 0; v < nVars(); v++)
+        if (decision[v] && value(v) == l_Undef && (next == var_Undef || flipActivity[v] > flipActivity[next]))
+            next = v;
+
+    return next == var_Undef ? lit_Undef : mkLit(next, polarity[next]);
+}
+
+Lit Solver::pickBranchLitUsingPropagationRate()
+{
+    assert(usePR);
+    Var    next   = var_Undef;
+    double max_pr = -1.0;
+
+    for (Var v = 0; v < nVars(); v++){
+        if (nbDecisionVar[v] == 0 || !decision[v] || value(v) != l_Undef) continue;
+
+        double pr = nbPropagations[v] * 1.0 / nbDecisionVar[v];
+        if (pr > max_pr){
+            max_pr = pr;
+            next   = v; } }
+
+    std::fill(nbDecisionVar.begin(), nbDecisionVar.end(), 0);
+    std::fill(nbPropagations.begin(), nbPropagations.end(), 0);
+
+    return next == var_Undef ? lit_Undef : mkLit(next, polarity[next]);
+}
+
 
 /*_________________________________________________________________________________________________
 |
@@ -550,6 +614,12 @@ void Solver::analyze(CRef confl, vec<Lit>& out_learnt, int& out_btlevel, int& ou
         assert(confl != CRef_Undef); // (otherwise should be UIP)
         Clause& c = ca[confl];
 
+        // Report the first use of an imported clause.
+        if (c.origin() != 0){
+            if (cbkImportedClauseUsed != NULL)
+                cbkImportedClauseUsed(issuer, c.origin());
+            c.origin(0); }
+
         // For binary clauses, we don't rearrange literals in propagate(), so check and make sure the first is an implied lit.
         if (p != lit_Undef && c.size() == 2 && value(c[0]) == l_False){
             assert(value(c[1]) == l_True);
@@ -826,6 +896,7 @@ CRef Solver::propagate()
 {
     CRef    confl     = CRef_Undef;
     int     num_props = 0;
+    Lit     last      = trail.size() > 0 ? trail.last() : lit_Undef;   // The decision propagated, for the propagation rate.
     watches.cleanAll();
     watches_bin.cleanAll();
 
@@ -894,6 +965,10 @@ CRef Solver::propagate()
     }
 
 ExitProp:;
+    if (usePR && num_props > 0){
+        nbPropagations[var(last)] += num_props;
+        nbDecisionVar [var(last)] += 1; }
+
     propagations += num_props;
     simpDB_props -= num_props;
 
@@ -1236,7 +1311,7 @@ lbool Solver::search(int& nof_conflicts)
                 restart = lbd_queue.full() && (lbd_queue.avg() * 0.8 > global_lbd_sum / conflicts_VSIDS);
                 cached = true;
             }
-            if (restart /*|| !withinBudget()*/){
+            if (restart || !withinBudget()){
                 lbd_queue.clear();
                 cached = false;
                 // Reached bound on number of conflicts:
@@ -1272,7 +1347,7 @@ lbool Solver::search(int& nof_conflicts)
             }
 
             if (next == lit_Undef) {
-                if (assumptions.size() > 0) { // Hack deguelasse
+                if (assumps_only && assumptions.size() > 0) { // Hack deguelasse
                     shrinkAssumptions();
                     return l_True;
                 }
@@ -1393,7 +1468,7 @@ lbool Solver::solve_()
         int weighted = phase_allotment;
         fflush(stdout);
 
-        while (status == l_Undef && weighted > 0 /*&& withinBudget()*/)
+        while (status == l_Undef && weighted > 0 && withinBudget())
             if (VSIDS)
                 status = search(weighted);
             else{
@@ -1403,7 +1478,7 @@ lbool Solver::solve_()
                 status = search(nof_conflicts);
             }
 
-        if (status != l_Undef /*|| !withinBudget()*/)
+        if (status != l_Undef || !withinBudget())
             break; // Should break here for correctness in incremental SAT solving.
 
         //VSIDS = !VSIDS;
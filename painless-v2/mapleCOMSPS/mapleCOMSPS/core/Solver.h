@@ -35,6 +35,7 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 #endif
 
 #include <memory>
+#include <vector>
 
 #include "../mtl/Vec.h"
 #include "../mtl/Heap.h"
@@ -108,8 +109,9 @@ public:
     void *   issuer;                                            // used as the callback parameter
 
     Lit  (* cbkImportUnit)  (void *);
-    bool (* cbkImportClause)(void *, int *, vec<Lit> &);
+    bool (* cbkImportClause)(void *, int *, int *, vec<Lit> &); // lbd and origin tag of the clause
     void (* cbkExportClause)(void *, int, vec<Lit> &);	        // callback for clause learning
+    void (* cbkImportedClauseUsed)(void *, int) = NULL;         // first use of an imported clause, by tag
 
 
     // Solving:
@@ -189,6 +191,7 @@ public:
     int       ccmin_mode;         // Controls conflict clause minimization (0=none, 1=basic, 2=deep).
     int       phase_saving;       // Controls the level of phase saving (0=none, 1=limited, 2=full).
     bool      rnd_pol;            // Use random polarities for branching heuristics.
+    bool      assumps_only;       // Stop with l_True once the assumptions are assigned, see 'getAssumptions()'.
     bool      rnd_init_act;       // Initialize variable activities with a small random value.
     double    garbage_frac;       // The fraction of wasted memory allowed before a garbage collection is triggered.
 
@@ -209,6 +212,17 @@ public:
     vec<uint32_t> conflicted;
     vec<uint32_t> almost_conflicted;
 
+    // Splitting heuristics, see 'pickBranchLitUsing...()':
+    //
+    bool             useFlip, usePR;   // Enable or not the use and update of flip activity and propagation rate.
+    std::vector<int> flipActivity;     // Number of flips for each variable.
+    std::vector<int> nbPropagations;   // Number of propagations caused by each variable.
+    std::vector<int> nbDecisionVar;    // Number of times each variable have been chosen as decision variable.
+
+    Lit      pickBranchLitUsingActivity        (); // Return the free variable with the highest VSIDS or LRB activity, without touching the order heaps.
+    Lit      pickBranchLitUsingFlipActivity    (); // Return the free variable whose saved phase flipped the most.
+    Lit      pickBranchLitUsingPropagationRate (); // Return the free variable with the highest propagation rate, and reset the rates.
+
 protected:
 
     // Helper structures:
@@ -128,7 +128,8 @@ class Clause {
         unsigned learnt    : 1;
         unsigned has_extra : 1;
         unsigned reloced   : 1;
-        unsigned lbd       : 26;
+        unsigned lbd       : 16;
+        unsigned origin    : 10;
         unsigned removable : 1;
         unsigned size      : 32; }                            header;
     union { Lit lit; float act; uint32_t abs; uint32_t touched; CRef rel; } data[0];
@@ -144,6 +145,7 @@ class Clause {
         header.reloced   = 0;
         header.size      = ps.size();
         header.lbd       = 0;
+        header.origin    = 0;
         header.removable = 1;
 
         for (int i = 0; i < ps.size(); i++) 
@@ -180,7 +182,10 @@ public:
     void         relocate    (CRef c)        { header.reloced = 1; data[0].rel = c; }
 
     int          lbd         ()      const   { return header.lbd; }
-    void         set_lbd     (int lbd)       { header.lbd = lbd; }
+    void         set_lbd     (int lbd)       { header.lbd = lbd < (1 << 16) ? lbd : (1 << 16) - 1; }
+    // Tag given by the importer of a clause until its first use in a conflict, 0 otherwise.
+    int          origin      ()      const   { return header.origin; }
+    void         origin      (int o)         { header.origin = o; }
     bool         removable   ()      const   { return header.removable; }
     void         removable   (bool b)        { header.removable = b; }
 
@@ -261,6 +266,7 @@ class ClauseAllocator : public RegionAllocator<uint32_t>
             to[cr].touched() = c.touched();
             to[cr].activity() = c.activity();
             to[cr].set_lbd(c.lbd());
+            to[cr].origin(c.origin());
             to[cr].removable(c.removable());
         }
         else if (to[cr].has_extra()) to[cr].calcAbstraction();
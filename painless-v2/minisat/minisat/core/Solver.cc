@@ -19,6 +19,7 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 **************************************************************************************************/
 
 #include <math.h>
+#include <algorithm>
 
 #include "minisat/mtl/Alg.h"
 #include "minisat/mtl/Sort.h"
@@ -90,6 +91,9 @@ Solver::Solver() :
   , solves(0), starts(0), decisions(0), rnd_decisions(0), propagations(0), conflicts(0)
   , dec_vars(0), num_clauses(0), num_learnts(0), clauses_literals(0), learnts_literals(0), max_literals(0), tot_literals(0)
 
+  , useFlip            (false)
+  , usePR              (false)
+
   , watches            (WatcherDeleted(ca))
   , order_heap         (VarOrderLt(activity))
   , ok                 (true)
@@ -142,6 +146,12 @@ Var Solver::newVar(lbool upol, bool dvar)
     decision .reserve(v);
     trail    .capacity(v+1);
     setDecisionVar(v, dvar);
+
+    // A released variable can be reused
+    if (useFlip && (int)flipActivity.size() <= v) flipActivity.resize(v+1, 0);
+    if (usePR && (int)nbPropagations.size() <= v){
+        nbPropagations.resize(v+1, 0);
+        nbDecisionVar .resize(v+1, 0); }
     return v;
 }
 
@@ -269,8 +279,9 @@ void Solver::cancelUntil(int level) {
         for (int c = trail.size()-1; c >= trail_lim[level]; c--){
             Var      x  = var(trail[c]);
             assigns [x] = l_Undef;
-            if (phase_saving > 1 || (phase_saving == 1 && c > trail_lim.last()))
-                polarity[x] = sign(trail[c]);
+            if (phase_saving > 1 || (phase_saving == 1 && c > trail_lim.last())){
+                if (useFlip && sign(trail[c]) != polarity[x]) flipActivity[x]++;
+                polarity[x] = sign(trail[c]); }
             insertVarOrder(x); }
         qhead = trail_lim[level];
         trail.shrink(trail.size() - trail_lim[level]);
@@ -312,6 +323,52 @@ Lit Solver::pickBranchLit()
 }
 
 
+Lit Solver::pickBranchLitUsingActivity()
+{
+    Var next = var_Undef;
+
+    for (Var v = 0; v < nVars(); v++)
+        if (decision[v] && value(v) == l_Undef && (next == var_Undef || activity[v] > activity[next]))
+            next = v;
+
+    return next == var_Undef ? lit_Undef : mkLit(next, polarity[next]);
+}
+
+
+Lit Solver::pickBranchLitUsingFlipActivity()
+{
+    assert(useFlip);
+    Var next = var_Undef;
+
+    for (Var v = 0; v < nVars(); v++)
+        if (decision[v] && value(v) == l_Undef && (next == var_Undef || flipActivity[v] > flipActivity[next]))
+            next = v;
+
+    return next == var_Undef ? lit_Undef : mkLit(next, polarity[next]);
+}
+
+
+Lit Solver::pickBranchLitUsingPropagationRate()
+{
+    assert(usePR);
+    Var    next   = var_Undef;
+    double max_pr = -1.0;
+
+    for (Var v = 0; v < nVars(); v++){
+        if (nbDecisionVar[v] == 0 || !decision[v] || value(v) != l_Undef) continue;
+
+        double pr = nbPropagations[v] * 1.0 / nbDecisionVar[v];
+        if (pr > max_pr){
+            max_pr = pr;
+            next   = v; } }
+
+    std::fill(nbDecisionVar.begin(), nbDecisionVar.end(), 0);
+    std::fill(nbPropagations.begin(), nbPropagations.end(), 0);
+
+    return next == var_Undef ? lit_Undef : mkLit(next, polarity[next]);
+}
+
+
 /*_________________________________________________________________________________________________
 |
 |  analyze : (confl : Clause*) (out_learnt : vec<Lit>&) (out_btlevel : int&)  ->  [void]
@@ -543,6 +600,7 @@ CRef Solver::propagate()
 {
     CRef    confl     = CRef_Undef;
     int     num_props = 0;
+    Lit     last      = trail.size() > 0 ? trail.last() : lit_Undef;   // The decision propagated, for the propagation rate.
 
     while (qhead < trail.size()){
         Lit            p   = trail[qhead++];     // 'p' is enqueued fact to propagate.
@@ -593,6 +651,10 @@ CRef Solver::propagate()
         }
         ws.shrink(i - j);
     }
+    if (usePR && num_props > 0){
+        nbPropagations[var(last)] += num_props;
+        nbDecisionVar [var(last)] += 1; }
+
     propagations += num_props;
     simpDB_props -= num_props;
 
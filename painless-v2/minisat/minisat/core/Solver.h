@@ -21,6 +21,8 @@ OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWA
 #ifndef Minisat_Solver_h
 #define Minisat_Solver_h
 
+#include <vector>
+
 #include "minisat/mtl/Vec.h"
 #include "minisat/mtl/Heap.h"
 #include "minisat/mtl/Alg.h"
@@ -169,6 +171,17 @@ public:
 
     bool                remove_satisfied; // Indicates whether possibly inefficient linear scan for satisfied clauses should be performed in 'simplify'.
 
+    // Splitting heuristics, see 'pickBranchLitUsing...()':
+    //
+    bool                useFlip, usePR;   // Enable or not the use and update of flip activity and propagation rate.
+    std::vector<int>    flipActivity;     // Number of flips for each variable.
+    std::vector<int>    nbPropagations;   // Number of propagations caused by each variable.
+    std::vector<int>    nbDecisionVar;    // Number of times each variable have been chosen as decision variable.
+
+    Lit      pickBranchLitUsingActivity        (); // Return the free variable with the highest activity, without touching the order heap.
+    Lit      pickBranchLitUsingFlipActivity    (); // Return the free variable whose saved phase flipped the most.
+    Lit      pickBranchLitUsingPropagationRate (); // Return the free variable with the highest propagation rate, and reset the rates.
+
 protected:
 
     // Helper structures:
@@ -0,0 +1,209 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2021
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#include "../clauses/ClauseBuffer.h"
+#include "../clauses/ClauseManager.h"
+#include "../utils/System.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+
+/// Microbenchmark of the clause buffer: producers add clauses of random lbd
+/// while consumers get them, for each overflow policy and against the linked
+/// list the ring replaced.
+///
+/// usage: clauseBufferBench [clauses per producer] [capacity]
+
+/// Lock-free linked list the ring replaced, kept as the reference.
+class ListBuffer
+{
+public:
+   ListBuffer()
+   {
+      ListElement * node = new ListElement(NULL);
+      head = tail = node;
+      nb   = 0;
+   }
+
+   void addClause(ClauseExchange * clause)
+   {
+      ListElement * last, * next;
+      ListElement * node = new ListElement(clause);
+
+      while (true) {
+         last = tail;
+         next = last->next;
+
+         if (last == tail) {
+            if (next == NULL) {
+               if (last->next.compare_exchange_strong(next, node))
+                  break;
+            } else {
+               tail.compare_exchange_strong(last, next);
+            }
+         }
+      }
+
+      tail.compare_exchange_strong(last, node);
+      nb++;
+   }
+
+   bool getClause(ClauseExchange ** clause)
+   {
+      ListElement * first, * last, * next;
+
+      while (true) {
+         first = head;
+         last  = tail;
+         next  = first->next;
+
+         if (first == head) {
+            if (first == last) {
+               if (next == NULL)
+                  return false;
+
+               tail.compare_exchange_strong(last, next);
+            } else {
+               *clause = next->clause;
+
+               if (head.compare_exchange_strong(first, next))
+                  break;
+            }
+         }
+      }
+
+      delete first;
+      nb--;
+
+      return true;
+   }
+
+   unsigned long dropped()
+   {
+      return 0;
+   }
+
+protected:
+   typedef struct ListElement
+   {
+      ClauseExchange * clause;
+
+      atomic<ListElement *> next;
+
+      ListElement(ClauseExchange * cls)
+      {
+         next   = NULL;
+         clause = cls;
+      }
+   } ListElement;
+
+   atomic<int> nb;
+
+   atomic<ListElement *> head;
+   atomic<ListElement *> tail;
+};
+
+/// Run the producers and consumers on buffer, return the clauses per second.
+template <typename Buffer>
+static double run(Buffer & buffer, int nProducers, int nConsumers,
+                  int nClauses, unsigned long & nGot)
+{
+   atomic<int> running(nProducers);
+   atomic<unsigned long> got(0);
+
+   vector<thread> threads;
+
+   double start = getAbsoluteTime();
+
+   for (int p = 0; p < nProducers; p++) {
+      threads.push_back(thread([&, p]() {
+         unsigned seed = p + 1;
+
+         for (int i = 0; i < nClauses; i++) {
+            ClauseExchange * cls = ClauseManager::allocClause(3);
+            cls->lbd  = 2 + rand_r(&seed) % 8;
+            cls->from = p;
+            buffer.addClause(cls);
+         }
+
+         running--;
+      }));
+   }
+
+   for (int c = 0; c < nConsumers; c++) {
+      threads.push_back(thread([&]() {
+         ClauseExchange * cls;
+         unsigned long nb = 0;
+
+         while (true) {
+            if (buffer.getClause(&cls)) {
+               ClauseManager::releaseClause(cls);
+               nb++;
+            } else if (running == 0 && buffer.getClause(&cls) == false) {
+               break;
+            } else {
+               this_thread::yield();
+            }
+         }
+
+         got += nb;
+      }));
+   }
+
+   for (size_t i = 0; i < threads.size(); i++) {
+      threads[i].join();
+   }
+
+   nGot = got;
+
+   return (double) nProducers * nClauses / (getAbsoluteTime() - start);
+}
+
+int main(int argc, char ** argv)
+{
+   int nClauses = argc > 1 ? atoi(argv[1]) : 1000000;
+   int capacity = argc > 2 ? atoi(argv[2]) : CLAUSE_BUFFER_CAPACITY;
+
+   const int configs[][2] = {{1, 1}, {4, 1}, {1, 4}, {4, 4}};
+
+   const char * names[] = {"keep", "drop-oldest", "drop-highest-lbd"};
+
+   printf("%d clauses per producer, capacity %d\n", nClauses, capacity);
+   printf("%-18s %3s %3s %10s %10s %10s\n", "queue", "P", "C", "Mops/s",
+          "got", "dropped");
+
+   for (auto & config : configs) {
+      unsigned long got;
+
+      ListBuffer list;
+      double speed = run(list, config[0], config[1], nClauses, got);
+      printf("%-18s %3d %3d %10.2f %10lu %10lu\n", "list", config[0],
+             config[1], speed / 1e6, got, list.dropped());
+
+      for (int policy = 0; policy < 3; policy++) {
+         ClauseBuffer ring((OverflowPolicy) policy, capacity);
+         speed = run(ring, config[0], config[1], nClauses, got);
+         printf("%-18s %3d %3d %10.2f %10lu %10lu\n", names[policy],
+                config[0], config[1], speed / 1e6, got, ring.dropped());
+      }
+   }
+
+   return 0;
+}
@@ -23,103 +23,265 @@
 
 using namespace std;
 
+/// Number of old clauses compared to a new one with OVERFLOW_DROP_HIGHEST_LBD.
+#define DROP_WINDOW 16
+
+/// Number of times a new clause tries to get in with OVERFLOW_DROP_HIGHEST_LBD
+/// while the consumers move the ring, before it is dropped.
+#define DROP_ATTEMPTS 4
+
 //-------------------------------------------------
 // Constructor & Destructor
 //-------------------------------------------------
-ClauseBuffer::ClauseBuffer()
+ClauseBuffer::ClauseBuffer(OverflowPolicy policy, int capacity) :
+   policy(policy)
 {
-   ListElement * node = new ListElement(NULL);
-   buffer.head = buffer.tail = node;
-   buffer.size = 0;
+   size_t nbCells = 2;
+   while (nbCells < (size_t) capacity)
+      nbCells <<= 1;
+
+   cells = new Cell[nbCells];
+   mask  = nbCells - 1;
+
+   for (size_t i = 0; i < nbCells; i++) {
+      cells[i].seq.store(i, memory_order_relaxed);
+      cells[i].clause.store(NULL, memory_order_relaxed);
+   }
+
+   enqueuePos = 0;
+   dequeuePos = 0;
+   nbDropped  = 0;
+   spillSize  = 0;
 }
 
 ClauseBuffer::~ClauseBuffer()
 {
+   delete [] cells;
 }
 
 //-------------------------------------------------
-//  Add clause(s)
+//  Ring
 //-------------------------------------------------
-void
-ClauseBuffer::addClause(ClauseExchange * clause)
+bool
+ClauseBuffer::push(ClauseExchange * clause)
 {
-   ListElement * tail, * next;
-   ListElement * node = new ListElement(clause);
+   Cell * cell;
+   size_t pos = enqueuePos.load(memory_order_relaxed);
 
    while (true) {
-      tail = buffer.tail;
-      next = tail->next;
-
-      if (tail == buffer.tail) {
-         if (next == NULL) {
-            if (tail->next.compare_exchange_strong(next, node)) {
-               break;
-            } 
-         } else {
-            buffer.tail.compare_exchange_strong(tail, next);
-         }
+      cell = &cells[pos & mask];
+      size_t seq = cell->seq.load(memory_order_acquire);
+      intptr_t dif = (intptr_t) seq - (intptr_t) pos;
+
+      if (dif == 0) {
+         if (enqueuePos.compare_exchange_weak(pos, pos + 1,
+                                              memory_order_relaxed))
+            break;
+      } else if (dif < 0) {
+         return false; // full
+      } else {
+         pos = enqueuePos.load(memory_order_relaxed);
       }
    }
 
-   buffer.tail.compare_exchange_strong(tail, node);
-   buffer.size++;
+   cell->clause.store(clause, memory_order_relaxed);
+   cell->lbd.store(clause->lbd, memory_order_relaxed);
+   cell->seq.store(pos + 1, memory_order_release);
+
+   return true;
 }
 
-void
-ClauseBuffer::addClauses(const vector<ClauseExchange *> & clauses) {
-   for (int i = 0; i < clauses.size(); i++) {
-      addClause(clauses[i]);
+bool
+ClauseBuffer::pop(ClauseExchange ** clause)
+{
+   Cell * cell;
+   size_t pos = dequeuePos.load(memory_order_relaxed);
+
+   while (true) {
+      cell = &cells[pos & mask];
+      size_t seq = cell->seq.load(memory_order_acquire);
+      intptr_t dif = (intptr_t) seq - (intptr_t) (pos + 1);
+
+      if (dif == 0) {
+         if (dequeuePos.compare_exchange_weak(pos, pos + 1,
+                                              memory_order_relaxed))
+            break;
+      } else if (dif < 0) {
+         return false; // empty
+      } else {
+         pos = dequeuePos.load(memory_order_relaxed);
+      }
    }
+
+   *clause = cell->clause.exchange(NULL);
+   cell->seq.store(pos + mask + 1, memory_order_release);
+
+   return true;
+}
+
+bool
+ClauseBuffer::replaceWorst(ClauseExchange * clause)
+{
+   size_t head = dequeuePos.load(memory_order_relaxed);
+
+   Cell * worst = NULL;
+   ClauseExchange * victim = NULL;
+   int worstLbd = clause->lbd;
+   int nb = 0;
+
+   for (size_t pos = head; pos < head + DROP_WINDOW; pos++, nb++) {
+      Cell * cell = &cells[pos & mask];
+
+      // Taken by a consumer, or not yet ready
+      if (cell->seq.load(memory_order_acquire) != pos + 1)
+         break;
+
+      ClauseExchange * old = cell->clause.load(memory_order_relaxed);
+      int lbd = cell->lbd.load(memory_order_relaxed);
+
+      if (old != NULL && lbd > worstLbd) {
+         worst    = cell;
+         victim   = old;
+         worstLbd = lbd;
+      }
+   }
+
+   if (nb == 0)
+      return false;
+
+   if (worst == NULL) {
+      drop(clause);
+      return true;
+   }
+
+   // Fails if a consumer took the victim meanwhile, if it takes it after the
+   // exchange it gets the new clause
+   if (worst->clause.compare_exchange_strong(victim, clause) == false)
+      return false;
+
+   // Only a hint, the cell may be reused already
+   worst->lbd.store(clause->lbd, memory_order_relaxed);
+   drop(victim);
+
+   return true;
 }
 
+bool
+ClauseBuffer::popSpill(ClauseExchange ** clause)
+{
+   if (spillSize == 0)
+      return false;
+
+   lock_guard<mutex> guard(spillLock);
+   if (spill.empty())
+      return false;
+
+   *clause = spill.front();
+   spill.pop_front();
+   spillSize--;
+
+   return true;
+}
 
 //-------------------------------------------------
-//  Get clause(s)
+//  Overflow
 //-------------------------------------------------
-bool
-ClauseBuffer::getClause(ClauseExchange ** clause) {
-   ListElement * head, * tail, * next;
+void
+ClauseBuffer::drop(ClauseExchange * clause)
+{
+   ClauseManager::releaseClause(clause);
+   nbDropped++;
+}
 
-   while (true) {
-      head = buffer.head;
-      tail = buffer.tail;
-      next = head->next;
-
-      if (head == buffer.head) {
-         if (head == tail) {
-            if (next == NULL)
-               return false;
-
-            buffer.tail.compare_exchange_strong(tail, next);
-         } else {
-            *clause = next->clause;
-
-            if (buffer.head.compare_exchange_strong(head, next)) {
-               break;
-            }
+void
+ClauseBuffer::overflow(ClauseExchange * clause)
+{
+   switch (policy) {
+      case OVERFLOW_KEEP :
+      {
+         lock_guard<mutex> guard(spillLock);
+         spill.push_back(clause);
+         spillSize++;
+         break;
+      }
+
+      case OVERFLOW_DROP_OLDEST :
+      {
+         ClauseExchange * old;
+         if (pop(&old))
+            drop(old);
+
+         if (push(clause) == false)
+            drop(clause);
+         break;
+      }
+
+      case OVERFLOW_DROP_HIGHEST_LBD :
+      {
+         // The clauses in the ring are not moved, the victim is replaced
+         for (int i = 0; i < DROP_ATTEMPTS; i++) {
+            if (replaceWorst(clause) || push(clause))
+               return;
          }
+
+         drop(clause);
+         break;
       }
    }
+}
+
+//-------------------------------------------------
+//  Add clause(s)
+//-------------------------------------------------
+void
+ClauseBuffer::addClause(ClauseExchange * clause)
+{
+   // The spilled clauses go first
+   if ((policy == OVERFLOW_KEEP && spillSize > 0) || push(clause) == false)
+      overflow(clause);
+}
 
-   delete head;
+void
+ClauseBuffer::addClauses(const vector<ClauseExchange *> & clauses) {
+   for (size_t i = 0; i < clauses.size(); i++) {
+      addClause(clauses[i]);
+   }
+}
 
-   buffer.size--;
 
-   return true;
+//-------------------------------------------------
+//  Get clause(s)
+//-------------------------------------------------
+bool
+ClauseBuffer::getClause(ClauseExchange ** clause) {
+   return pop(clause) || popSpill(clause);
 }
 
 void
-ClauseBuffer::getClauses(vector<ClauseExchange *> & clauses)
+ClauseBuffer::getClauses(vector<ClauseExchange *> & clauses, int maxClauses)
 {
-   ClauseExchange * cls;
-
+   // Only the clauses present at the call are taken
    int nClauses = size();
+   if (maxClauses >= 0 && maxClauses < nClauses)
+      nClauses = maxClauses;
+
+   ClauseExchange * cls;
    int nClausesGet = 0;
 
-   while (getClause(&cls) && nClausesGet < nClauses) {
+   while (nClausesGet < nClauses && pop(&cls)) {
       clauses.push_back(cls);
       nClausesGet++;
    }
+
+   if (nClausesGet < nClauses && spillSize > 0) {
+      lock_guard<mutex> guard(spillLock);
+      while (nClausesGet < nClauses && !spill.empty()) {
+         clauses.push_back(spill.front());
+         spill.pop_front();
+         spillSize--;
+         nClausesGet++;
+      }
+   }
 }
 
 //-------------------------------------------------
@@ -128,5 +290,15 @@ ClauseBuffer::getClauses(vector<ClauseExchange *> & clauses)
 int
 ClauseBuffer::size()
 {
-   return buffer.size.load();
+   size_t head = dequeuePos.load(memory_order_relaxed);
+   size_t tail = enqueuePos.load(memory_order_relaxed);
+   intptr_t nb = (intptr_t) tail - (intptr_t) head;
+
+   return (nb > 0 ? nb : 0) + spillSize.load();
+}
+
+unsigned long
+ClauseBuffer::dropped()
+{
+   return nbDropped.load();
 }
@@ -23,19 +23,41 @@
 #include "../clauses/ClauseManager.h"
 
 #include <atomic>
+#include <deque>
 #include <memory>
+#include <mutex>
 #include <stdio.h>
 #include <vector>
 
 
 using namespace std;
 
-/// Clause buffer is a queue containning shared clauses.
+/// Default number of clauses held by a clause buffer.
+#define CLAUSE_BUFFER_CAPACITY (1 << 14)
+
+/// What a full clause buffer does with a new clause.
+enum OverflowPolicy
+{
+   /// Keep every clause, the extra ones wait in a locked list, in order.
+   OVERFLOW_KEEP = 0,
+   /// Drop the oldest clauses of the buffer.
+   OVERFLOW_DROP_OLDEST = 1,
+   /// Drop the clause of highest lbd among the oldest ones and the new one,
+   /// which takes the place of the dropped clause.
+   OVERFLOW_DROP_HIGHEST_LBD = 2
+};
+
+/// Clause buffer is a bounded queue containning shared clauses.
+///
+/// The clauses are stored in a ring of cells, each cell having a sequence
+/// number telling if it is free for the producers or ready for the
+/// consumers, so that several threads can add and get clauses without lock.
 class ClauseBuffer
 {
 public:
-   /// Constructor.
-   ClauseBuffer();
+   /// Constructor, the capacity is rounded up to a power of two.
+   ClauseBuffer(OverflowPolicy policy = OVERFLOW_KEEP,
+                int capacity = CLAUSE_BUFFER_CAPACITY);
 
    /// Destructor.
    ~ClauseBuffer();
@@ -49,42 +71,66 @@ public:
    /// Dequeue a shared clause.
    bool getClause (ClauseExchange ** clause);
 
-   /// Dequeue shared clauses.
-   void getClauses(vector<ClauseExchange *> & clauses);
+   /// Dequeue shared clauses, at most maxClauses if positive.
+   void getClauses(vector<ClauseExchange *> & clauses, int maxClauses = -1);
 
    /// Return the current size of the buffer
    int size();
 
+   /// Return the number of clauses dropped because the buffer was full.
+   unsigned long dropped();
+
 protected:
-   typedef struct ListElement
+   typedef struct Cell
    {
-      ClauseExchange * clause;
+      atomic<size_t> seq;
 
-      atomic<ListElement *> next;         
+      /// Taken by the consumer with an exchange, so that a full buffer can
+      /// replace a clause waiting in the ring.
+      atomic<ClauseExchange *> clause;
 
-      ListElement(ClauseExchange * cls)
-      {
-         next   = NULL;
-         clause = cls;
-      }
+      /// Lbd of the clause, read without touching the clause.
+      atomic<int> lbd;
+   } Cell;
 
-      ~ListElement()
-      {
-      }
-   } ListElement;
+   /// Try to enqueue without handling the overflow.
+   bool push(ClauseExchange * clause);
 
-   typedef struct ListRoot
-   {
-      atomic<int> size;
-
-      atomic<ListElement *> head;
-      atomic<ListElement *> tail;
-     ~ListRoot()
-     {
-     }
-     
-   } ListRoot;
-
-   /// Root of producer/customers lists
-   ListRoot buffer;
+   /// Try to dequeue from the ring.
+   bool pop(ClauseExchange ** clause);
+
+   /// Replace the clause of highest lbd among the oldest ones by clause if it
+   /// is worse, return false if clause is the worst or the ring moved.
+   bool replaceWorst(ClauseExchange * clause);
+
+   /// Dequeue from the spill list.
+   bool popSpill(ClauseExchange ** clause);
+
+   /// Handle a clause that does not fit in the ring.
+   void overflow(ClauseExchange * clause);
+
+   /// Release a dropped clause.
+   void drop(ClauseExchange * clause);
+
+   /// Ring of cells.
+   Cell * cells;
+   size_t mask;
+
+   OverflowPolicy policy;
+
+   /// Positions of the producers and of the consumers, on their own cache
+   /// lines.
+   char padding0[64];
+   atomic<size_t> enqueuePos;
+   char padding1[64 - sizeof(size_t)];
+   atomic<size_t> dequeuePos;
+   char padding2[64 - sizeof(size_t)];
+
+   atomic<unsigned long> nbDropped;
+
+   /// Clauses that did not fit with OVERFLOW_KEEP, the new clauses go there
+   /// too until it is empty so that the order is kept.
+   atomic<int> spillSize;
+   deque<ClauseExchange *> spill;
+   mutex spillLock;
 };
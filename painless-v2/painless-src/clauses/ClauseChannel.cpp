@@ -0,0 +1,182 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2021
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#include "../clauses/ClauseChannel.h"
+#include "../clauses/ClauseManager.h"
+
+/// Hazard of a reader that is not reading, and cursor of a removed reader.
+#define NONE SIZE_MAX
+
+#define MASK (CHANNEL_CAPACITY - 1)
+
+//-------------------------------------------------
+// Constructor & Destructor
+//-------------------------------------------------
+ClauseChannel::ClauseChannel()
+{
+   for (int l = 0; l < 2; l++) {
+      logs[l].slots = new ClauseExchange *[CHANNEL_CAPACITY];
+      logs[l].end   = 0;
+   }
+
+   nbReaders = 0;
+   dropped   = 0;
+}
+
+ClauseChannel::~ClauseChannel()
+{
+   for (int l = 0; l < 2; l++) {
+      size_t end   = logs[l].end;
+      size_t begin = end > CHANNEL_CAPACITY ? end - CHANNEL_CAPACITY : 0;
+
+      for (size_t i = begin; i < end; i++) {
+         ClauseManager::releaseClause(logs[l].slots[i & MASK]);
+      }
+
+      delete [] logs[l].slots;
+   }
+}
+
+//-------------------------------------------------
+// Writer
+//-------------------------------------------------
+void
+ClauseChannel::publish(const vector<ClauseExchange *> & clauses)
+{
+   for (auto cls : clauses) {
+      append(logs[cls->size == 1 ? 0 : 1], cls);
+   }
+}
+
+void
+ClauseChannel::append(Log & log, ClauseExchange * clause)
+{
+   size_t end = log.end.load(memory_order_relaxed);
+
+   if (end >= CHANNEL_CAPACITY) {
+      // The slot of position old is reused, the late readers skip it
+      size_t old = end - CHANNEL_CAPACITY;
+      int    nb  = nbReaders;
+
+      for (int i = 0; i < nb; i++) {
+         Cursor & cursor = log.cursors[i];
+         size_t   pos    = cursor.pos;
+
+         while (pos <= old && !cursor.pos.compare_exchange_weak(pos, old + 1));
+
+         if (cursor.hazard == old) {
+            // Being read, the new clause is not published
+            ClauseManager::releaseClause(clause);
+            dropped++;
+            return;
+         }
+      }
+
+      ClauseManager::releaseClause(log.slots[old & MASK]);
+   }
+
+   log.slots[end & MASK] = clause;
+   log.end.store(end + 1, memory_order_release);
+}
+
+//-------------------------------------------------
+// Readers
+//-------------------------------------------------
+int
+ClauseChannel::addReader(int id)
+{
+   // The slot of a removed reader is reused first
+   int nb     = nbReaders;
+   int reader = 0;
+   while (reader < nb && readerIds[reader] != -1)
+      reader++;
+
+   if (reader >= CHANNEL_MAX_READERS)
+      return -1;
+
+   for (int l = 0; l < 2; l++) {
+      // Only the clauses published from now on are read
+      logs[l].cursors[reader].hazard = NONE;
+      logs[l].cursors[reader].pos    = logs[l].end.load();
+   }
+
+   readerIds[reader] = id;
+
+   if (reader == nb)
+      nbReaders++;
+
+   return reader;
+}
+
+void
+ClauseChannel::removeReader(int reader)
+{
+   if (reader < 0)
+      return;
+
+   for (int l = 0; l < 2; l++) {
+      logs[l].cursors[reader].pos = NONE;
+   }
+
+   // The slot can be given to a new reader once its cursors are cleared
+   readerIds[reader] = -1;
+}
+
+ClauseExchange *
+ClauseChannel::next(int reader, bool unit)
+{
+   if (reader < 0)
+      return NULL;
+
+   Log    & log    = logs[unit ? 0 : 1];
+   Cursor & cursor = log.cursors[reader];
+
+   while (true) {
+      size_t pos = cursor.pos;
+
+      if (pos >= log.end.load(memory_order_acquire))
+         return NULL;
+
+      // The writer either sees the hazard or has moved the cursor
+      cursor.hazard = pos;
+      if (cursor.pos != pos) {
+         cursor.hazard = NONE;
+         continue;
+      }
+
+      ClauseExchange * cls = log.slots[pos & MASK];
+
+      if (cls->from != readerIds[reader])
+         return cls;
+
+      // Own clause, skipped
+      cursor.pos.compare_exchange_strong(pos, pos + 1);
+      cursor.hazard = NONE;
+   }
+}
+
+void
+ClauseChannel::done(int reader, bool unit)
+{
+   Cursor & cursor = logs[unit ? 0 : 1].cursors[reader];
+
+   size_t pos = cursor.hazard;
+   cursor.pos.compare_exchange_strong(pos, pos + 1);
+   cursor.hazard = NONE;
+}
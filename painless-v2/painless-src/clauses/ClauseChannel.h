@@ -0,0 +1,143 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2021
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "../clauses/ClauseExchange.h"
+
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+/// Number of clauses kept by a log of a channel, a power of two.
+#define CHANNEL_CAPACITY (1 << 16)
+
+/// Maximum number of readers of a channel.
+#define CHANNEL_MAX_READERS 256
+
+/// Broadcast of the shared clauses of a sharer to its consumers.
+///
+/// The channel is a ring of clauses written by one thread, the units and the
+/// other clauses in two separate logs. Each reader has its own cursor, and
+/// publishes the position it is reading so that the writer does not reuse
+/// the slot meanwhile. The channel holds one reference on each clause, that
+/// it releases when the slot is reused: no reference is taken per reader.
+/// A reader that lags a whole ring behind skips the oldest clauses.
+class ClauseChannel
+{
+public:
+   /// Constructor.
+   ClauseChannel();
+
+   /// Destructor, the clauses left are released.
+   ~ClauseChannel();
+
+   /// Append clauses, the references of the caller go to the channel. Only
+   /// one thread can publish.
+   void publish(const vector<ClauseExchange *> & clauses);
+
+   /// Register a reader, that skips the clauses of solver id. Return -1 if
+   /// there are already CHANNEL_MAX_READERS readers. Only the publishing
+   /// thread can add readers.
+   int addReader(int id);
+
+   /// The reader does not read anymore.
+   void removeReader(int reader);
+
+   /// Give the next unit or clause for a reader, NULL if none. The clause
+   /// stays valid until done is called.
+   ClauseExchange * next(int reader, bool unit);
+
+   /// The reader is done with the clause given by next.
+   void done(int reader, bool unit);
+
+   /// Number of clauses not published because a reader was using their slot.
+   unsigned long getDropped() { return dropped; }
+
+protected:
+   /// Position of a reader in a log, on its own cache line.
+   typedef struct Cursor
+   {
+      /// Next position to read.
+      atomic<size_t> pos;
+
+      /// Position being read, NONE if not reading.
+      atomic<size_t> hazard;
+
+      char padding[64 - 2 * sizeof(size_t)];
+   } Cursor;
+
+   typedef struct Log
+   {
+      ClauseExchange ** slots;
+
+      /// Number of clauses published.
+      atomic<size_t> end;
+
+      Cursor cursors[CHANNEL_MAX_READERS];
+   } Log;
+
+   /// Write a clause in a log.
+   void append(Log & log, ClauseExchange * clause);
+
+   /// Logs of the units and of the other clauses.
+   Log logs[2];
+
+   /// Solver skipped by each reader, -1 once removed. The slots up to
+   /// nbReaders have been used, the removed ones are reused.
+   atomic<int> readerIds[CHANNEL_MAX_READERS];
+   atomic<int> nbReaders;
+
+   atomic<unsigned long> dropped;
+};
+
+/// Reader of a channel owned by a consumer.
+class ChannelReader
+{
+public:
+   /// Constructor, the reader skips the clauses of solver id.
+   ChannelReader(const shared_ptr<ClauseChannel> & channel, int id)
+      : channel(channel)
+   {
+      reader = channel->addReader(id);
+   }
+
+   /// Destructor.
+   ~ChannelReader()
+   {
+      channel->removeReader(reader);
+   }
+
+   /// The channel has a slot for this reader.
+   bool isAttached() { return reader >= 0; }
+
+   /// Give the next unit or clause, NULL if none.
+   ClauseExchange * next(bool unit) { return channel->next(reader, unit); }
+
+   /// Done with the clause given by next.
+   void done(bool unit) { channel->done(reader, unit); }
+
+   shared_ptr<ClauseChannel> channel;
+
+protected:
+   int reader;
+};
@@ -19,40 +19,177 @@
 
 #include "../clauses/ClauseDatabase.h"
 #include "../clauses/ClauseExchange.h"
+#include "../clauses/ClauseFilter.h"
 #include "../clauses/ClauseManager.h"
 #include "../utils/DebugUtils.h"
 #include "../utils/Logger.h"
 
+#include <algorithm>
 #include <stdio.h>
 #include <string.h>
 
 using namespace std;
 
-ClauseDatabase::ClauseDatabase()
+/// Weights of the cost of a clause.
+#define LBD_WEIGHT    4
+#define SOURCE_WEIGHT 8
+#define AGE_WEIGHT    2
+
+/// Age in rounds after which a clause gets no older.
+#define AGE_LIMIT 8
+
+ClauseDatabase::ClauseDatabase(int capacity) : capacity(capacity)
 {
+   nbLits = 0;
+   round  = 0;
 }
 
 ClauseDatabase::~ClauseDatabase()
 {
 }
 
+long
+ClauseDatabase::computeCost(const Entry & entry)
+{
+   long age = min(round - entry.arrival, (long) AGE_LIMIT);
+
+   return LBD_WEIGHT * entry.clause->lbd + entry.clause->size -
+          SOURCE_WEIGHT * (entry.nbSources - 1) + AGE_WEIGHT * age;
+}
+
+//-------------------------------------------------
+//  Heap
+//-------------------------------------------------
+void
+ClauseDatabase::swapEntries(size_t a, size_t b)
+{
+   swap(heap[a], heap[b]);
+   positions[heap[a].fingerprint] = a;
+   positions[heap[b].fingerprint] = b;
+}
+
+void
+ClauseDatabase::siftUp(size_t pos)
+{
+   while (pos > 0) {
+      size_t parent = (pos - 1) / 2;
+      if (heap[parent].cost >= heap[pos].cost)
+         break;
+      swapEntries(pos, parent);
+      pos = parent;
+   }
+}
+
+void
+ClauseDatabase::siftDown(size_t pos)
+{
+   while (true) {
+      size_t worst = pos;
+      size_t left  = 2 * pos + 1;
+      size_t right = left + 1;
+
+      if (left < heap.size() && heap[left].cost > heap[worst].cost)
+         worst = left;
+      if (right < heap.size() && heap[right].cost > heap[worst].cost)
+         worst = right;
+      if (worst == pos)
+         break;
+
+      swapEntries(pos, worst);
+      pos = worst;
+   }
+}
+
+void
+ClauseDatabase::removeEntry(size_t pos, bool release)
+{
+   Entry removed = heap[pos];
+
+   swapEntries(pos, heap.size() - 1);
+   heap.pop_back();
+   positions.erase(removed.fingerprint);
+   if (pos < heap.size()) {
+      siftUp(pos);
+      siftDown(pos);
+   }
+
+   nbLits -= removed.clause->size;
+   if (release)
+      ClauseManager::releaseClause(removed.clause);
+}
+
+//-------------------------------------------------
+//  Add clause(s)
+//-------------------------------------------------
 void
 ClauseDatabase::addClause(ClauseExchange * clause)
 {
-	int clsSize = clause->size;
+   Entry entry;
+   entry.clause      = clause;
+   entry.nbSources   = 1;
+   entry.fingerprint = ClauseFilter::fingerprint(clause->lits, clause->size);
+
+   lock.lock();
+
+   entry.arrival = round;
+   entry.cost    = computeCost(entry);
+
+   auto it = positions.find(entry.fingerprint);
+   if (it != positions.end()) {
+      // Given again before being selected
+      Entry & known = heap[it->second];
+      known.nbSources++;
+      known.cost = computeCost(known);
+      siftDown(it->second);
+      lock.unlock();
+      ClauseManager::releaseClause(clause);
+      return;
+   }
 
-	while (clauses.size() < clsSize) {
-      vector<ClauseExchange *> newVector;
-		clauses.push_back(newVector);
-	}
+   // The worst clauses make room for a better one
+   while (nbLits + clause->size > capacity && !heap.empty() &&
+          heap[0].cost > entry.cost) {
+      removeEntry(0, true);
+   }
 
-   if ((clauses[clsSize-1].size() + 1) * clsSize < 1000) {
-      clauses[clsSize-1].push_back(clause);
-   } else {
+   if (nbLits + clause->size > capacity) {
+      lock.unlock();
       ClauseManager::releaseClause(clause);
+      return;
+   }
+
+   heap.push_back(entry);
+   positions[entry.fingerprint] = heap.size() - 1;
+   siftUp(heap.size() - 1);
+   nbLits += clause->size;
+
+   lock.unlock();
+}
+
+void
+ClauseDatabase::addSource(ClauseExchange * clause)
+{
+   uint64_t fingerprint = ClauseFilter::fingerprint(clause->lits,
+                                                    clause->size);
+
+   lock.lock();
+
+   auto it = positions.find(fingerprint);
+   if (it != positions.end()) {
+      Entry & known = heap[it->second];
+      known.nbSources++;
+      known.cost = computeCost(known);
+      siftDown(it->second);
    }
+
+   lock.unlock();
+
+   ClauseManager::releaseClause(clause);
 }
 
+//-------------------------------------------------
+//  Select clauses
+//-------------------------------------------------
 int
 ClauseDatabase::giveSelection(vector<ClauseExchange *> & selectedCls,
                               unsigned totalSize, int * selectCount)
@@ -60,37 +197,42 @@ ClauseDatabase::giveSelection(vector<ClauseExchange *> & selectedCls,
    int used     = 0;
    *selectCount = 0;
 
-   for (unsigned i = 0; i < clauses.size(); i++) {
-      unsigned clsSize = i + 1;
-      unsigned left    = totalSize - used;
+   lock.lock();
 
-      if (left < clsSize) // No more place
-         return used;
-      
-      if (left >= clsSize * clauses[i].size()) {
-         // If all the clauses of size clsSize (i+1) can be added
-         used = used + clsSize * clauses[i].size();
+   // The clauses younger than AGE_LIMIT get older, the heap is rebuilt from
+   // the bottom in linear time
+   round++;
+   for (size_t i = 0; i < heap.size(); i++) {
+      heap[i].cost = computeCost(heap[i]);
+   }
+   for (size_t i = heap.size() / 2; i > 0; i--) {
+      siftDown(i - 1);
+   }
 
-         selectedCls.insert(selectedCls.end(), clauses[i].begin(),
-                            clauses[i].end());
+   // Cheapest first, the clauses too long for what is left are skipped
+   vector<pair<long, uint64_t> > cheapest;
+   for (size_t i = 0; i < heap.size(); i++) {
+      cheapest.push_back(make_pair(-heap[i].cost, heap[i].fingerprint));
+   }
+   make_heap(cheapest.begin(), cheapest.end());
 
-         *selectCount += clauses[i].size();
+   while (!cheapest.empty() && used < (int) totalSize) {
+      pop_heap(cheapest.begin(), cheapest.end());
+      size_t pos = positions[cheapest.back().second];
+      cheapest.pop_back();
 
-         clauses[i].clear();
-      } else {
-         // Else how many clauses can be added
-         // Add them one by one
-         unsigned nCls = left / clsSize;
-         used              = used + clsSize * nCls;
+      ClauseExchange * cls = heap[pos].clause;
+      if (totalSize - used < (unsigned) cls->size)
+         continue;
 
-         for (unsigned k = 0; k < nCls; k++) {
-            selectedCls.push_back(clauses[i].back());
-            clauses[i].pop_back();
+      used += cls->size;
+      selectedCls.push_back(cls);
+      *selectCount += 1;
 
-            *selectCount += 1;
-         }
-      }
+      removeEntry(pos, false);
    }
 
+   lock.unlock();
+
    return used;
 }
@@ -22,22 +22,38 @@
 #include "../clauses/ClauseExchange.h"
 #include "../utils/Threading.h"
 
+#include <stdint.h>
+#include <unordered_map>
 #include <vector>
 
 using namespace std;
 
+/// Default number of literals held by a clause database.
+#define DATABASE_CAPACITY 50000
+
 /// Clause database used for Hordesat
+///
+/// The clauses wait in a heap whose top is the worst clause, that makes room
+/// for better ones once the capacity is reached. A clause costs more with a
+/// high lbd and size, less when several producers gave it and when it is
+/// recent. The selection takes the cheapest clauses that fit the budget, in
+/// the order of a second heap built over the costs.
+/// The database can be used by several threads.
 class ClauseDatabase
 {
 public:
-   /// Constructor.
-	ClauseDatabase();
+   /// Constructor, the capacity is given in literals.
+	ClauseDatabase(int capacity = DATABASE_CAPACITY);
 
    /// Destructor
 	~ClauseDatabase();
 
 	/// Add a shared clause to the database.
 	void addClause(ClauseExchange * clause);
+
+   /// Count one more producer for a clause given again, if it is still in
+   /// the database. The given clause is released.
+   void addSource(ClauseExchange * clause);
 	 
    /// Fill the given buffer with shared clauses.
 	/// @return the number of used literals.
@@ -45,6 +61,44 @@ public:
                      int * selectCount);
 
 protected:
-   /// Vector of vector of shared clauses, on vector per size.
-	vector<vector<ClauseExchange *> > clauses;
+   typedef struct Entry
+   {
+      ClauseExchange * clause;
+
+      /// Cost of the clause, the lower the better.
+      long cost;
+
+      /// Number of producers, and round of arrival.
+      int  nbSources;
+      long arrival;
+
+      /// Fingerprint of the sorted literals.
+      uint64_t fingerprint;
+   } Entry;
+
+   /// Cost of an entry, from its clause, sources and age in rounds.
+   long computeCost(const Entry & entry);
+
+   /// Heap operations, the entry of highest cost is on top.
+   void siftUp(size_t pos);
+   void siftDown(size_t pos);
+   void swapEntries(size_t a, size_t b);
+
+   /// Remove the entry at pos, its clause is released if release is true.
+   void removeEntry(size_t pos, bool release);
+
+   /// Heap of the clauses.
+   vector<Entry> heap;
+
+   /// Position in the heap of each fingerprint.
+   unordered_map<uint64_t, size_t> positions;
+
+   /// Literals held and maximum.
+   int nbLits;
+   int capacity;
+
+   /// Number of selections, used as the age of the clauses.
+   long round;
+
+   Mutex lock;
 };
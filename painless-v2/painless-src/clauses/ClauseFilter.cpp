@@ -1,69 +1,330 @@
-// Copyright (c) 2015 Tomas Balyo, Karlsruhe Institute of Technology
-// This file is from HordeSAT (https://github.com/biotomas/hordesat)
-/*
- * ClauseFilter.cpp
- *
- *  Created on: Aug 12, 2014
- *      Author: balyo
- */
+// -----------------------------------------------------------------------------
+// Copyright (C) 2021
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
 
 #include "ClauseFilter.h"
 
-#include <stdlib.h>
-#include <stdio.h>
+#include <algorithm>
 
 using namespace std;
 
-#define NUM_PRIMES 12
+/// Words of a block, one cache line.
+#define BLOCK_WORDS 8
 
-static unsigned const int primes [] = {2038072819, 2038073287,	2038073761,	2038074317,
-		2038072823,	2038073321,	2038073767,	2038074319,
-		2038072847,	2038073341,	2038073789,	2038074329};
+/// Bits set per clause in its block.
+#define NUM_HASHES 4
 
-size_t ClauseFilter::commutativeHashFunction(int* cls, int size, int which) {
-	size_t res = 0;
-	// skip the first int (it is the glue)
-	for (size_t j = 1; j < size; j++) {
-		int lit = cls[j];
-		res ^= lit * primes[abs((which * lit) % NUM_PRIMES)];
-	}
-	return res % NUM_BITS;
+/// A generation is retired once 1/FILL_LIMIT of its bits are set.
+#define FILL_LIMIT 4
+
+/// Initial number of slots of the unit set.
+#define UNIT_SLOTS 1024
+
+/// Slots of the exact table looked at for a clause.
+#define PROBE_LENGTH 16
+
+//-------------------------------------------------
+// Constructor & Destructor
+//-------------------------------------------------
+ClauseFilter::ClauseFilter(FilterMode mode, int logBits) : mode(mode)
+{
+   if (mode == FILTER_EXACT) {
+      nbWords = 0;
+      table   = vector<atomic<uint64_t> >(FILTER_EXACT_BYTES /
+                                          sizeof(uint64_t));
+   } else {
+      if (logBits < 9)
+         logBits = 9; // one block
+
+      nbWords = ((size_t) 1 << logBits) / 64;
+
+      for (int i = 0; i < 2; i++) {
+         generations[i] = vector<atomic<uint64_t> >(nbWords);
+      }
+   }
+
+   current    = 0;
+   bitsSet    = 0;
+   rotations  = 0;
+   duplicates = 0;
+   used       = 0;
+   inserts    = 0;
+
+   units.assign(UNIT_SLOTS, 0);
+   nbUnits = 0;
+}
+
+ClauseFilter::~ClauseFilter()
+{
+}
+
+//-------------------------------------------------
+// Hash
+//-------------------------------------------------
+uint64_t
+ClauseFilter::hashClause(const int * cls, int size)
+{
+   // Sum and xor are commutative, the loop has no dependency between the
+   // literals so that it is vectorized by the compiler
+   uint32_t sum = size;
+   uint32_t xr  = 0;
+
+   for (int i = 0; i < size; i++) {
+      uint32_t x = (uint32_t) cls[i];
+      sum += x * 0x9E3779B1u;
+      xr  ^= (x ^ (x >> 15)) * 0x85EBCA6Bu;
+   }
+
+   // Murmur3 finalizer
+   uint64_t h = ((uint64_t) sum << 32) | xr;
+   h ^= h >> 33;
+   h *= 0xFF51AFD7ED558CCDull;
+   h ^= h >> 33;
+   h *= 0xC4CEB9FE1A85EC53ull;
+   h ^= h >> 33;
+
+   return h;
+}
+
+uint64_t
+ClauseFilter::fingerprint(const int * cls, int size)
+{
+   static thread_local vector<int> sorted;
+   sorted.assign(cls, cls + size);
+   sort(sorted.begin(), sorted.end());
+
+   uint64_t h = size;
+   for (int i = 0; i < size; i++) {
+      h ^= (uint32_t) sorted[i];
+      h *= 0x9E3779B97F4A7C15ull;
+      h ^= h >> 29;
+   }
+
+   h ^= h >> 33;
+   h *= 0xFF51AFD7ED558CCDull;
+   h ^= h >> 33;
+
+   return h;
+}
+
+//-------------------------------------------------
+// Register
+//-------------------------------------------------
+bool
+ClauseFilter::registerClause(const int * cls, int size)
+{
+   bool isNew;
+
+   if (size == 1)
+      isNew = registerUnit(cls[0]);
+   else if (mode == FILTER_EXACT)
+      isNew = registerExact(cls, size);
+   else
+      isNew = registerBloom(cls, size);
+
+   if (!isNew)
+      duplicates++;
+
+   return isNew;
+}
+
+bool
+ClauseFilter::registerExact(const int * cls, int size)
+{
+   uint64_t fp  = fingerprint(cls, size) >> 8;
+   if (fp == 0)
+      fp = 1; // an entry is never empty
+   uint8_t  age = inserts.load(memory_order_relaxed) / (table.size() / 8);
+
+   // Range reduction of the fingerprint to the table
+   size_t start = (size_t) (((unsigned __int128) fp << 8) * table.size() >> 64);
+
+   size_t   victim    = start;
+   uint8_t  victimAge = 0;
+   for (int i = 0; i < PROBE_LENGTH; i++) {
+      size_t   pos   = (start + i) % table.size();
+      uint64_t entry = table[pos].load(memory_order_relaxed);
+
+      if (entry == 0) {
+         uint64_t expected = 0;
+         if (table[pos].compare_exchange_strong(expected, (fp << 8) | age)) {
+            used++;
+            inserts++;
+            return true;
+         }
+         entry = expected; // taken meanwhile
+      }
+
+      if ((entry >> 8) == fp) {
+         // Seen again, the entry gets younger
+         table[pos].compare_exchange_strong(entry, (fp << 8) | age);
+         return false;
+      }
+
+      uint8_t entryAge = age - (uint8_t) entry;
+      if (entryAge >= victimAge) {
+         victim    = pos;
+         victimAge = entryAge;
+      }
+   }
+
+   // Full around the clause, the oldest entry makes room
+   table[victim].store((fp << 8) | age, memory_order_relaxed);
+   inserts++;
+   rotations++;
+
+   return true;
+}
+
+bool
+ClauseFilter::registerBloom(const int * cls, int size)
+{
+   uint64_t h = hashClause(cls, size);
+
+   // The block comes from the high bits, the bits in the block from the low
+   // ones
+   size_t nbBlocks = nbWords / BLOCK_WORDS;
+   size_t block    = (size_t) ((h >> 36) & (nbBlocks - 1)) * BLOCK_WORDS;
+
+   uint64_t masks[BLOCK_WORDS] = {0};
+   for (int i = 0; i < NUM_HASHES; i++) {
+      int bit = (h >> (9 * i)) & 511;
+      masks[bit / 64] |= (uint64_t) 1 << (bit % 64);
+   }
+
+   int cur = current.load(memory_order_relaxed);
+   vector<atomic<uint64_t> > & newGen = generations[cur];
+   vector<atomic<uint64_t> > & oldGen = generations[1 - cur];
+
+   bool inNew = true, inOld = true;
+   for (int i = 0; i < BLOCK_WORDS; i++) {
+      if (masks[i] == 0)
+         continue;
+      if ((newGen[block + i].load(memory_order_relaxed) & masks[i]) != masks[i])
+         inNew = false;
+      if ((oldGen[block + i].load(memory_order_relaxed) & masks[i]) != masks[i])
+         inOld = false;
+   }
+
+   if (inNew)
+      return false;
+
+   // Clauses seen in the previous generation are kept in the new one
+   size_t newBits = 0;
+   for (int i = 0; i < BLOCK_WORDS; i++) {
+      if (masks[i] == 0)
+         continue;
+      uint64_t old = newGen[block + i].fetch_or(masks[i], memory_order_relaxed);
+      newBits += __builtin_popcountll(masks[i] & ~old);
+   }
+
+   if (bitsSet.fetch_add(newBits) + newBits >= nbWords * 64 / FILL_LIMIT)
+      rotate();
+
+   return !inOld;
 }
 
-ClauseFilter::ClauseFilter() {
-	s1 = new bitset<NUM_BITS>();
+bool
+ClauseFilter::registerUnit(int lit)
+{
+   lock_guard<mutex> guard(unitLock);
+
+   size_t mask = units.size() - 1;
+   size_t pos  = ((uint32_t) lit * 0x9E3779B1u) & mask;
+
+   while (units[pos] != 0) {
+      if (units[pos] == lit)
+         return false;
+      pos = (pos + 1) & mask;
+   }
+
+   units[pos] = lit;
+   nbUnits++;
+
+   // Keep the load under one half
+   if (nbUnits * 2 > units.size()) {
+      vector<int> old;
+      old.swap(units);
+      units.assign(old.size() * 2, 0);
+      mask = units.size() - 1;
+
+      for (int u : old) {
+         if (u == 0)
+            continue;
+         pos = ((uint32_t) u * 0x9E3779B1u) & mask;
+         while (units[pos] != 0)
+            pos = (pos + 1) & mask;
+         units[pos] = u;
+      }
+   }
+
+   return true;
 }
 
-ClauseFilter::~ClauseFilter() {
-	delete s1;
+//-------------------------------------------------
+// Aging
+//-------------------------------------------------
+void
+ClauseFilter::rotate()
+{
+   lock_guard<mutex> guard(rotateLock);
+
+   if (bitsSet < nbWords * 64 / FILL_LIMIT)
+      return; // already done by another thread
+
+   int cur = current.load();
+   vector<atomic<uint64_t> > & oldGen = generations[1 - cur];
+   for (size_t i = 0; i < nbWords; i++) {
+      oldGen[i].store(0, memory_order_relaxed);
+   }
+
+   current = 1 - cur;
+   bitsSet = 0;
+   rotations++;
 }
 
-bool ClauseFilter::registerClause(int* cls, int size) {
-	// unit clauses always get in
-	if (size == 1) {
-		if (unitSet.count(cls[0])) {
-			return false;
-		}
-		unitSet.insert(cls[0]);
-		return true;
-	}
-
-	size_t h1 = commutativeHashFunction(cls, size, 1);
-	size_t h2 = commutativeHashFunction(cls, size, 2);
-	size_t h3 = commutativeHashFunction(cls, size, 3);
-	size_t h4 = commutativeHashFunction(cls, size, 4);
-
-	if (s1->test(h1) && s1->test(h2) && s1->test(h3) && s1->test(h4)) {
-		return false;
-	} else {
-		s1->set(h1, true);
-		s1->set(h2, true);
-		s1->set(h3, true);
-		s1->set(h4, true);
-		return true;
-	}
+void
+ClauseFilter::clear()
+{
+   lock_guard<mutex> guard(rotateLock);
+
+   for (int g = 0; g < 2; g++) {
+      for (size_t i = 0; i < nbWords; i++) {
+         generations[g][i].store(0, memory_order_relaxed);
+      }
+   }
+   bitsSet = 0;
+
+   for (size_t i = 0; i < table.size(); i++) {
+      table[i].store(0, memory_order_relaxed);
+   }
+   used = 0;
+
+   lock_guard<mutex> unitGuard(unitLock);
+   units.assign(UNIT_SLOTS, 0);
+   nbUnits = 0;
 }
 
-void ClauseFilter::clear() {
-	s1->reset();
+double
+ClauseFilter::fillRatio()
+{
+   if (mode == FILTER_EXACT)
+      return (double) used.load() / table.size();
+
+   return (double) bitsSet.load() / (nbWords * 64);
 }
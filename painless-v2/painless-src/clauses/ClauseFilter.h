@@ -1,45 +1,128 @@
-// Copyright (c) 2015 Tomas Balyo, Karlsruhe Institute of Technology
-// This file is from HordeSAT (https://github.com/biotomas/hordesat)
-/*
- * ClauseFilter.h
- *
- *  Created on: Aug 12, 2014
- *      Author: balyo
- */
-
-#ifndef CLAUSEFILTER_H_
-#define CLAUSEFILTER_H_
+// -----------------------------------------------------------------------------
+// Copyright (C) 2021
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
 
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <stdint.h>
 #include <vector>
-#include <bitset>
-#include <unordered_set>
 
 using namespace std;
 
-//#define NUM_BITS 268435399 // 32MB
-#define NUM_BITS 26843543 // 3,2MB
+/// Default number of bits of a filter generation, as a power of two.
+#define FILTER_LOG_BITS 23
 
-class ClauseFilter {
-public:
-	ClauseFilter();
-	virtual ~ClauseFilter();
-	/**
-	 * Return false if the given clause has already been registered
-	 * otherwise add it to the filter and return true.
-	 */
-	bool registerClause(int* cls, int size);
-	/**
-	 * Clear the filter, i.e., return to its initial state.
-	 */
-	void clear();
-
-private:
-	bitset<NUM_BITS>* s1;
-	unordered_set<int> unitSet;
-	size_t hashFunction(int* cls, int size);
-	size_t commutativeHashFunction(int* cls, int size, int which);
-	size_t unitHashFunction(int var);
+/// Memory of the fingerprint table of an exact filter.
+#define FILTER_EXACT_BYTES (3200 * 1024)
 
+/// How a filter tells that a clause was already seen.
+enum FilterMode
+{
+   /// Bloom filter, may reject a new clause.
+   FILTER_BLOOM = 0,
+   /// Table of 56-bit fingerprints of the sorted clauses.
+   FILTER_EXACT = 1
 };
 
-#endif /* CLAUSEFILTER_H_ */
+/// Filter of the clauses already seen, HordeSat style.
+///
+/// The clauses are hashed in one pass, independently of the order of their
+/// literals, into a blocked Bloom filter: the bits of a clause are all in the
+/// same cache line. A generation is retired once a quarter of its bits are
+/// set, a clause is known if it is in the current or the previous generation,
+/// so that the false positives do not grow on long runs.
+///
+/// The exact mode keeps a fingerprint of the sorted literals with its age in
+/// an open addressed table, the oldest entry around the slot of a clause is
+/// replaced when the table is full.
+///
+/// Several threads can register clauses at the same time.
+class ClauseFilter
+{
+public:
+   /// Constructor, a Bloom generation has 2^logBits bits.
+   ClauseFilter(FilterMode mode = FILTER_BLOOM, int logBits = FILTER_LOG_BITS);
+
+   /// Destructor.
+   virtual ~ClauseFilter();
+
+   /// Return false if the given clause has already been registered
+   /// otherwise add it to the filter and return true.
+   bool registerClause(const int * cls, int size);
+
+   /// Clear the filter, i.e., return to its initial state.
+   void clear();
+
+   /// Ratio of bits set in the current generation, or of used slots.
+   double fillRatio();
+
+   /// Number of retired generations, or of replaced entries.
+   unsigned long getRotations() { return rotations; }
+
+   /// Number of clauses rejected as already seen.
+   unsigned long getDuplicates() { return duplicates; }
+
+   /// Fingerprint of the sorted literals.
+   static uint64_t fingerprint(const int * cls, int size);
+
+protected:
+   /// Order independent 64-bit hash of a clause.
+   static uint64_t hashClause(const int * cls, int size);
+
+   /// Retire the previous generation once the current one is full enough.
+   void rotate();
+
+   /// Return false if the unit was already registered, else add it.
+   bool registerUnit(int lit);
+
+   /// Bloom and exact versions of registerClause.
+   bool registerBloom(const int * cls, int size);
+   bool registerExact(const int * cls, int size);
+
+   FilterMode mode;
+
+   atomic<unsigned long> duplicates;
+
+   /// Words of a generation, 8 per block of 512 bits.
+   size_t nbWords;
+
+   /// The two generations, current is the one receiving the new clauses.
+   vector<atomic<uint64_t> > generations[2];
+   atomic<int> current;
+
+   /// Bits set in the current generation.
+   atomic<size_t> bitsSet;
+
+   atomic<unsigned long> rotations;
+
+   mutex rotateLock;
+
+   /// Entries of the exact mode: fingerprint << 8 | age, 0 if empty.
+   vector<atomic<uint64_t> > table;
+   atomic<size_t> used;
+
+   /// Age of the new entries, increased every table.size() / 8 clauses.
+   atomic<size_t> inserts;
+
+   /// Open addressed set of the units, 0 for an empty slot.
+   vector<int> units;
+   size_t nbUnits;
+   mutex unitLock;
+};
@@ -0,0 +1,208 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2021
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#include "../clauses/ClauseManager.h"
+
+#include <mutex>
+#include <vector>
+
+/// Bytes of the chunks carved into entries.
+#define POOL_CHUNK_BYTES (64 * 1024)
+
+/// States of a pool: owned by a thread, and given up by joinClauseManager.
+#define POOL_IN_USE  1
+#define POOL_RETIRED 2
+
+/// Size classes of the clauses allocated by one thread.
+///
+/// A pool is owned by one thread at a time, the other threads give back its
+/// entries through the remote free lists. The pool of a finished thread is
+/// kept for the next one. joinClauseManager frees the pools that are not
+/// owned, the others are freed by their thread when it ends.
+struct ClausePool
+{
+   ClauseSizeClass classes[NB_SIZE_CLASSES];
+
+   /// Memory of the entries.
+   vector<void *> chunks;
+
+   /// POOL_IN_USE and POOL_RETIRED flags.
+   atomic<int> state;
+};
+
+/// Free a pool and its entries.
+static void freePool(ClausePool * pool)
+{
+   for (auto chunk : pool->chunks) {
+      free(chunk);
+   }
+   delete pool;
+}
+
+/// Pool of the calling thread, given back when the thread ends.
+struct ClausePoolHandle
+{
+   ClausePool * pool = NULL;
+
+   ~ClausePoolHandle()
+   {
+      // The last side to give up the pool frees it
+      if (pool && pool->state.fetch_and(~POOL_IN_USE, memory_order_acq_rel) &
+                  POOL_RETIRED)
+         freePool(pool);
+   }
+};
+
+static vector<ClausePool *> pools;
+static mutex poolsLock;
+static atomic<bool> poolsEnabled(false);
+
+static thread_local ClausePoolHandle localPool;
+
+/// Give the pool of the calling thread, claim or create it if needed.
+static ClausePool * getLocalPool()
+{
+   if (localPool.pool)
+      return localPool.pool;
+
+   lock_guard<mutex> guard(poolsLock);
+
+   for (auto pool : pools) {
+      int expected = 0;
+      if (pool->state.compare_exchange_strong(expected, POOL_IN_USE,
+                                              memory_order_acquire)) {
+         localPool.pool = pool;
+         return pool;
+      }
+   }
+
+   ClausePool * pool = new ClausePool;
+   pool->state = POOL_IN_USE;
+   for (int i = 0; i < NB_SIZE_CLASSES; i++) {
+      ClauseSizeClass & sizeClass = pool->classes[i];
+      sizeClass.pool       = pool;
+      sizeClass.entryBytes = sizeof(void *) + sizeof(ClauseExchange) +
+                             sizeof(int) * (1 << i);
+      sizeClass.entryBytes = (sizeClass.entryBytes + sizeof(void *) - 1) &
+                             ~(sizeof(void *) - 1);
+      sizeClass.localFree  = NULL;
+      sizeClass.remoteFree = NULL;
+      sizeClass.chunkPos   = NULL;
+      sizeClass.chunkEnd   = NULL;
+   }
+   pools.push_back(pool);
+
+   localPool.pool = pool;
+   return pool;
+}
+
+/// Index of the smallest class holding size literals.
+static int sizeClassOf(int size)
+{
+   if (size <= 1)
+      return 0;
+
+   return 32 - __builtin_clz(size - 1);
+}
+
+void ClauseManager::initClauseManager()
+{
+   poolsEnabled = true;
+}
+
+ClauseExchange * ClauseManager::allocClause(int size)
+{
+   int idx = sizeClassOf(size);
+   void ** entry;
+
+   if (!poolsEnabled || idx >= NB_SIZE_CLASSES) {
+      entry  = (void **) malloc(entrySize(size));
+      *entry = NULL;
+   } else {
+      ClausePool * pool = getLocalPool();
+      ClauseSizeClass & sizeClass = pool->classes[idx];
+
+      if (sizeClass.localFree == NULL) {
+         sizeClass.localFree = sizeClass.remoteFree.exchange(NULL,
+                                                       memory_order_acquire);
+      }
+
+      if (sizeClass.localFree) {
+         entry = (void **) sizeClass.localFree;
+         sizeClass.localFree = *entry;
+      } else {
+         if (sizeClass.chunkPos + sizeClass.entryBytes > sizeClass.chunkEnd) {
+            char * chunk = (char *) malloc(POOL_CHUNK_BYTES);
+            pool->chunks.push_back(chunk);
+            sizeClass.chunkPos = chunk;
+            sizeClass.chunkEnd = chunk + POOL_CHUNK_BYTES;
+         }
+
+         entry = (void **) sizeClass.chunkPos;
+         sizeClass.chunkPos += sizeClass.entryBytes;
+      }
+
+      *entry = (void *) ((uintptr_t) &sizeClass | POOL_HEADER_TAG);
+   }
+
+   ClauseExchange * ptr = (ClauseExchange *) (entry + 1);
+
+   ptr->size   = size;
+   ptr->nbRefs = 1;
+
+   return ptr;
+}
+
+void ClauseManager::freeEntry(ClauseSizeClass * sizeClass, void ** entry)
+{
+   if (localPool.pool == sizeClass->pool) {
+      *entry = sizeClass->localFree;
+      sizeClass->localFree = entry;
+      return;
+   }
+
+   // Only the owner takes the remote entries, all at once, so no ABA
+   void * head = sizeClass->remoteFree.load(memory_order_relaxed);
+   do {
+      *entry = head;
+   } while (!sizeClass->remoteFree.compare_exchange_weak(head, entry,
+                                                         memory_order_release,
+                                                         memory_order_relaxed));
+}
+
+void ClauseManager::joinClauseManager()
+{
+   lock_guard<mutex> guard(poolsLock);
+
+   poolsEnabled = false;
+
+   // The pool of the calling thread is given up first
+   if (localPool.pool) {
+      localPool.pool->state.fetch_and(~POOL_IN_USE, memory_order_acq_rel);
+      localPool.pool = NULL;
+   }
+
+   // The threads still running keep their pool until they end
+   for (auto pool : pools) {
+      if ((pool->state.fetch_or(POOL_RETIRED, memory_order_acq_rel) &
+           POOL_IN_USE) == 0)
+         freePool(pool);
+   }
+   pools.clear();
+}
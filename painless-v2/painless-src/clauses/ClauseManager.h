@@ -20,26 +20,99 @@
 #pragma once
 
 #include <atomic>
+#include <stdint.h>
 #include <stdlib.h>
 
 #include "../clauses/ClauseExchange.h"
 
 using namespace std;
 
+/// Block of memory holding several shared clauses, it is freed with its last
+/// clause.
+struct ClauseSlab
+{
+   /// Number of live clauses, plus one while the slab is being filled.
+   atomic<int> nbClauses;
+
+   /// Bytes used and available in data.
+   size_t used;
+   size_t capacity;
+
+   alignas(sizeof(void *)) char data[0];
+};
+
+struct ClausePool;
+
+/// Free clauses of one size of a pool.
+struct ClauseSizeClass
+{
+   /// Pool owning the clauses of this class.
+   ClausePool * pool;
+
+   /// Bytes of an entry, header included.
+   size_t entryBytes;
+
+   /// Free entries, only used by the owner thread.
+   void * localFree;
+
+   /// Entries freed by the other threads.
+   atomic<void *> remoteFree;
+
+   /// Free space at the end of the last chunk.
+   char * chunkPos;
+   char * chunkEnd;
+};
+
+/// Number of size classes, the clauses of up to 2^(n-1) literals are pooled.
+#define NB_SIZE_CLASSES 9
+
+/// Tag of the headers pointing to a size class instead of a slab.
+#define POOL_HEADER_TAG 1
+
 /// Class in charge of the management of shared clauses.
+///
+/// Every clause is preceded by a header: null if the clause was allocated
+/// alone, a pointer to its slab, or a tagged pointer to the size class of the
+/// thread pool it comes from.
 class ClauseManager
 {
 public:
    /// Init the clause manager.
-   static void initClauseManager()
+   static void initClauseManager();
+
+   /// Alloc a new shared clause from the pool of the calling thread.
+   static ClauseExchange * allocClause(int size);
+
+   /// Alloc a slab big enough for nbClauses clauses of nbLits literals in
+   /// total.
+   static ClauseSlab * allocSlab(int nbClauses, int nbLits)
    {
+      size_t capacity = nbClauses * entrySize(0) + nbLits * sizeof(int) +
+                        nbClauses * sizeof(void *); // alignment of the entries
+
+      ClauseSlab * slab = (ClauseSlab *) malloc(sizeof(ClauseSlab) + capacity);
+      slab->nbClauses = 1;
+      slab->used      = 0;
+      slab->capacity  = capacity;
+
+      return slab;
    }
 
-   /// Alloc a new shared clause.
-   static ClauseExchange * allocClause(int size)
+   /// Alloc a new shared clause in a slab.
+   static ClauseExchange * allocClause(ClauseSlab * slab, int size)
    {
-      ClauseExchange * ptr;
-      ptr = (ClauseExchange *) malloc(sizeof(ClauseExchange) + sizeof(int) * size);
+      size_t bytes = entrySize(size);
+      bytes = (bytes + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
+
+      if (slab->used + bytes > slab->capacity)
+         return allocClause(size);
+
+      ClauseSlab ** header = (ClauseSlab **) (slab->data + slab->used);
+      *header     = slab;
+      slab->used += bytes;
+      slab->nbClauses++;
+
+      ClauseExchange * ptr = (ClauseExchange *) (header + 1);
 
       ptr->size   = size;
       ptr->nbRefs = 1;
@@ -47,6 +120,14 @@ public:
       return ptr;
    }
 
+   /// Release the slab once filled, it is freed with its last clause.
+   static void releaseSlab(ClauseSlab * slab)
+   {
+      if (slab->nbClauses.fetch_sub(1) - 1 <= 0) {
+         free(slab);
+      }
+   }
+
    /// Increase the number of references to a shared clause.
    static void increaseClause(ClauseExchange * cls, int refs = 1)
    {
@@ -59,12 +140,30 @@ public:
       int oldValue = cls->nbRefs.fetch_sub(1); // atomic decrementation
 
       if (oldValue - 1 <= 0) {
-         free(cls);
+         void ** header = ((void **) cls) - 1;
+         uintptr_t owner = (uintptr_t) *header;
+
+         if (owner == 0) {
+            free(header);
+         } else if (owner & POOL_HEADER_TAG) {
+            freeEntry((ClauseSizeClass *) (owner & ~POOL_HEADER_TAG), header);
+         } else {
+            releaseSlab((ClauseSlab *) owner);
+         }
       }
    }
    
-   /// Join the clause manager.
-   static void joinClauseManager()
+   /// Join the clause manager, the pools are freed, those of the threads
+   /// still running when they end.
+   static void joinClauseManager();
+
+private:
+   /// Bytes used by a clause and its header.
+   static size_t entrySize(int size)
    {
+      return sizeof(ClauseSlab *) + sizeof(ClauseExchange) + sizeof(int) * size;
    }
+
+   /// Give back a pooled entry to its size class.
+   static void freeEntry(ClauseSizeClass * sizeClass, void ** entry);
 };
@@ -0,0 +1,109 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2021
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#include "../clauses/ClauseManager.h"
+#include "../clauses/FastLane.h"
+
+#include <algorithm>
+
+//-------------------------------------------------
+// Constructor & Destructor
+//-------------------------------------------------
+FastLane *
+FastLane::getInstance()
+{
+   static FastLane ins;
+   return &ins;
+}
+
+FastLane::FastLane()
+{
+   enabled = false;
+   filter  = NULL;
+
+   for (int l = 0; l < 2; l++) {
+      logs[l].end = 0;
+   }
+}
+
+FastLane::~FastLane()
+{
+   delete filter;
+}
+
+void
+FastLane::enable()
+{
+   logs[0].slots = vector<atomic<ClauseExchange *> >(FAST_LANE_UNITS);
+   logs[1].slots = vector<atomic<ClauseExchange *> >(FAST_LANE_BINARIES);
+
+   filter  = new ClauseFilter(FILTER_EXACT);
+   enabled = true;
+}
+
+//-------------------------------------------------
+// Writers
+//-------------------------------------------------
+bool
+FastLane::publish(ClauseExchange * cls)
+{
+   Log & log = logs[cls->size == 1 ? 0 : 1];
+
+   if (log.end.load(memory_order_relaxed) >= log.slots.size())
+      return false;
+
+   if (filter->registerClause(cls->lits, cls->size) == false) {
+      ClauseManager::releaseClause(cls);
+      return true;
+   }
+
+   size_t pos = log.end.fetch_add(1);
+   if (pos >= log.slots.size())
+      return false; // filled meanwhile
+
+   log.slots[pos].store(cls, memory_order_release);
+
+   if (cls->from >= 0 && listener)
+      listener();
+
+   return true;
+}
+
+void
+FastLane::clear()
+{
+   for (int l = 0; l < 2; l++) {
+      size_t end = min(logs[l].end.load(), logs[l].slots.size());
+
+      for (size_t i = 0; i < end; i++) {
+         ClauseExchange * cls = logs[l].slots[i].exchange(NULL);
+         if (cls)
+            ClauseManager::releaseClause(cls);
+      }
+
+      logs[l].end = 0;
+   }
+}
+
+size_t
+FastLane::size(bool unit)
+{
+   const Log & log = logs[unit ? 0 : 1];
+   return min(log.end.load(), log.slots.size());
+}
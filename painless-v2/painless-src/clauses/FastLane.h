@@ -0,0 +1,110 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2021
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "../clauses/ClauseExchange.h"
+#include "../clauses/ClauseFilter.h"
+
+#include <atomic>
+#include <functional>
+#include <vector>
+
+using namespace std;
+
+/// Number of units kept by the fast lane.
+#define FAST_LANE_UNITS (1 << 16)
+
+/// Number of binary clauses kept by the fast lane.
+#define FAST_LANE_BINARIES (1 << 18)
+
+/// Units and binary clauses known by the process, shared without a sharer.
+///
+/// The lane is an append-only log of the units and one of the binaries. Any
+/// thread publishes in it: a slot is reserved with an atomic increment, the
+/// clause becomes visible once its pointer is written. Each solver reads the
+/// logs from its own position when it imports, i.e., at its restarts and at
+/// level 0, and the comm thread sends the local ones to the other ranks. The
+/// clauses are kept until the end, so that a solver created late gets all of
+/// them; once a log is full the clauses go through the sharers again.
+class FastLane
+{
+public:
+   static FastLane * getInstance();
+
+   /// Allocate the logs, the lane is not used before.
+   void enable();
+
+   /// Return true if the units and binaries go through the lane.
+   bool isEnabled() { return enabled; }
+
+   /// Called after a local clause is published, to wake up the comm thread.
+   void setListener(const function<void()> & listener)
+   {
+      this->listener = listener;
+   }
+
+   /// Publish a unit or a binary clause, the reference of the caller goes to
+   /// the lane. A clause already published is released.
+   /// @return false if the log is full, the caller keeps its reference.
+   bool publish(ClauseExchange * cls);
+
+   /// Clause at position pos of a log, NULL if not yet published.
+   ClauseExchange * get(bool unit, size_t pos)
+   {
+      Log & log = logs[unit ? 0 : 1];
+
+      if (pos >= log.slots.size() || pos >= log.end.load(memory_order_acquire))
+         return NULL;
+
+      return log.slots[pos].load(memory_order_acquire);
+   }
+
+   /// Release the clauses, before the clause manager is joined.
+   void clear();
+
+   /// Number of clauses published in a log.
+   size_t size(bool unit);
+
+   /// Number of clauses rejected as already published.
+   unsigned long getDuplicates() { return filter ? filter->getDuplicates() : 0; }
+
+protected:
+   FastLane();
+
+   ~FastLane();
+
+   typedef struct Log
+   {
+      vector<atomic<ClauseExchange *> > slots;
+
+      /// Number of reserved slots, may go beyond the capacity.
+      atomic<size_t> end;
+   } Log;
+
+   bool enabled;
+
+   /// Logs of the units and of the binaries.
+   Log logs[2];
+
+   /// Clauses already published.
+   ClauseFilter * filter;
+
+   function<void()> listener;
+};
@@ -0,0 +1,200 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2021
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#include "../comm/ClauseCodec.h"
+
+#include <algorithm>
+#include <limits.h>
+#include <stdlib.h>
+
+static inline void putVarint(vector<uint8_t> &buf, unsigned value)
+{
+    while (value >= 0x80)
+    {
+        buf.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    buf.push_back((uint8_t)value);
+}
+
+static inline bool compareVar(int a, int b)
+{
+    return abs(a) < abs(b);
+}
+
+void ClauseCodec::encode(vector<ClauseExchange *> &clauses, vector<uint8_t> &buf)
+{
+    stable_sort(clauses.begin(), clauses.end(),
+                [](ClauseExchange *a, ClauseExchange *b) { return a->size < b->size; });
+
+    vector<int> lits;
+    size_t i = 0;
+    while (i < clauses.size())
+    {
+        int size = clauses[i]->size;
+        size_t last = i;
+        while (last < clauses.size() && clauses[last]->size == size)
+            last++;
+
+        putVarint(buf, size);
+        putVarint(buf, last - i);
+
+        for (; i < last; i++)
+        {
+            ClauseExchange *cls = clauses[i];
+            // Some producers do not compute the lbd (units for instance)
+            int lbd = (cls->lbd > 0 && cls->lbd <= size) ? cls->lbd : size;
+            putVarint(buf, lbd);
+
+            lits.assign(cls->lits, cls->lits + size);
+            sort(lits.begin(), lits.end(), compareVar);
+
+            int prev = 0;
+            for (int lit : lits)
+            {
+                int var = abs(lit);
+                putVarint(buf, ((unsigned)(var - prev) << 1) | (lit < 0));
+                prev = var;
+            }
+        }
+    }
+}
+
+void ClauseCodec::encodeFeedback(const vector<ExportFeedback> &feedback, vector<uint8_t> &buf)
+{
+    putVarint(buf, feedback.size());
+    for (auto &fb : feedback)
+    {
+        putVarint(buf, fb.rank);
+        putVarint(buf, fb.budget);
+        putVarint(buf, fb.lbdLimit);
+    }
+}
+
+void ClauseCodec::encodeSectionHeader(int hop, int length, vector<uint8_t> &buf)
+{
+    putVarint(buf, hop);
+    putVarint(buf, length);
+}
+
+PackedClauseReader::PackedClauseReader(const uint8_t *buf, int length)
+    : pos(buf), end(buf + length), bufferEnd(buf + length)
+{
+}
+
+bool PackedClauseReader::readVarint(unsigned &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7)
+    {
+        if (pos == end)
+        {
+            bad = true;
+            return false;
+        }
+        uint8_t byte = *pos++;
+        value |= (unsigned)(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    bad = true;
+    return false;
+}
+
+bool PackedClauseReader::readFeedback(vector<ExportFeedback> &feedback)
+{
+    feedback.clear();
+    unsigned count;
+    if (!readVarint(count))
+        return false;
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        unsigned rank, budget, lbdLimit;
+        if (!readVarint(rank) || !readVarint(budget) || !readVarint(lbdLimit))
+            return false;
+        feedback.push_back({(int)rank, (int)budget, (int)lbdLimit});
+    }
+    return true;
+}
+
+bool PackedClauseReader::nextSection(int &hop)
+{
+    // Skip what is left of the previous section
+    if (inSection)
+        pos = end;
+    end = bufferEnd;
+    inSection = true;
+    groupLeft = 0;
+
+    if (bad || pos == end)
+        return false;
+
+    unsigned value, length;
+    if (!readVarint(value) || !readVarint(length))
+        return false;
+    if (value > INT_MAX || length > (unsigned)(bufferEnd - pos))
+    {
+        bad = true;
+        return false;
+    }
+    hop = value;
+    end = pos + length;
+    return true;
+}
+
+bool PackedClauseReader::next(vector<int> &lits, int &lbd)
+{
+    if (bad)
+        return false;
+
+    while (groupLeft == 0)
+    {
+        if (pos == end)
+            return false;
+        if (!readVarint(groupSize) || !readVarint(groupLeft) || groupSize == 0)
+        {
+            bad = true;
+            return false;
+        }
+    }
+
+    unsigned value;
+    if (!readVarint(value))
+        return false;
+    lbd = value;
+
+    lits.clear();
+    int var = 0;
+    for (unsigned i = 0; i < groupSize; i++)
+    {
+        if (!readVarint(value))
+            return false;
+        var += value >> 1;
+        if (var == 0)
+        {
+            bad = true;
+            return false;
+        }
+        lits.push_back(value & 1 ? -var : var);
+    }
+    groupLeft--;
+
+    return true;
+}
@@ -0,0 +1,93 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2021
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "../clauses/ClauseExchange.h"
+
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+/// Export limits a rank asks to one of its peers.
+struct ExportFeedback
+{
+    int rank;     ///< Rank of the peer the feedback is for.
+    int budget;   ///< Literals per round the peer may send.
+    int lbdLimit; ///< Maximal lbd of the clauses to send, 0 for none.
+};
+
+// Wire format of a batch of shared clauses:
+//   { [size] [count] { [lbd] [lit] ... [lit] } * count } * groups
+// Every number is an unsigned LEB128 varint. Clauses are grouped by size in
+// increasing order. Within a clause the literals are sorted by variable and
+// each one is stored as ((var - previousVar) << 1 | negative).
+//
+// Messages exchanged between ranks carry the feedback of the sender and
+// sections of clauses that travelled the same number of hops:
+//   [count] { [rank] [budget] [lbdLimit] } * count
+//   { [hop] [length in bytes] [packed clauses] } * sections
+class ClauseCodec
+{
+public:
+    /// Append the packed form of the clauses to the buffer, the vector of
+    /// clauses is sorted by size.
+    static void encode(vector<ClauseExchange *> &clauses, vector<uint8_t> &buf);
+
+    /// Append the feedback header to the buffer.
+    static void encodeFeedback(const vector<ExportFeedback> &feedback, vector<uint8_t> &buf);
+
+    /// Append the header of a section of length bytes.
+    static void encodeSectionHeader(int hop, int length, vector<uint8_t> &buf);
+};
+
+/// Iterate over the clauses of a packed buffer.
+class PackedClauseReader
+{
+public:
+    PackedClauseReader(const uint8_t *buf, int length);
+
+    /// Read the feedback header, must be called before the first clause.
+    bool readFeedback(vector<ExportFeedback> &feedback);
+
+    /// Restrict the reader to the next section, return false at the end of
+    /// the buffer.
+    bool nextSection(int &hop);
+
+    /// Read the next clause, return false at the end of the buffer.
+    bool next(vector<int> &lits, int &lbd);
+
+    /// Return true if the buffer was not a valid packed batch.
+    bool corrupted() const { return bad; }
+
+private:
+    bool readVarint(unsigned &value);
+
+    const uint8_t *pos;
+    const uint8_t *end;
+    const uint8_t *bufferEnd;
+    bool inSection = false;
+
+    /// Size and clauses left in the current group.
+    unsigned groupSize = 0;
+    unsigned groupLeft = 0;
+
+    bool bad = false;
+};
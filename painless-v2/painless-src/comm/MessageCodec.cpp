@@ -0,0 +1,238 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2021
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#include "../comm/MessageCodec.h"
+
+#include <cstring>
+#include <zlib.h>
+
+#define LZ_MIN_MATCH 4
+#define LZ_HASH_BITS 12
+#define LZ_MAX_OFFSET 0xffff
+
+// bound on the original length of a message, against corrupted headers
+#define MAX_MESSAGE_BYTES (1 << 26)
+
+static inline void putVarint(vector<uint8_t> &buf, unsigned value)
+{
+    while (value >= 0x80)
+    {
+        buf.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    buf.push_back((uint8_t)value);
+}
+
+static inline bool getVarint(const uint8_t *&pos, const uint8_t *end, unsigned &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 35 && pos < end; shift += 7)
+    {
+        uint8_t byte = *pos++;
+        value |= (unsigned)(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+// Lengths of 15 or more are continued after the token
+static inline void putLength(vector<uint8_t> &buf, unsigned length)
+{
+    if (length >= 15)
+        putVarint(buf, length - 15);
+}
+
+static inline bool getLength(const uint8_t *&pos, const uint8_t *end, unsigned &length)
+{
+    if (length < 15)
+        return true;
+    unsigned extra;
+    if (!getVarint(pos, end, extra))
+        return false;
+    length += extra;
+    return true;
+}
+
+static inline unsigned hashSequence(const uint8_t *p)
+{
+    uint32_t seq;
+    memcpy(&seq, p, sizeof(seq));
+    return (seq * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+void MessageCodec::pack(int codec, const uint8_t *src, int length, vector<uint8_t> &dst)
+{
+    dst.clear();
+    if (codec != CODEC_RAW)
+    {
+        dst.push_back(codec);
+        putVarint(dst, length);
+        size_t header = dst.size();
+
+        if (codec == CODEC_LZ)
+        {
+            lzCompress(src, length, dst);
+        }
+        else
+        {
+            uLongf bound = compressBound(length);
+            dst.resize(header + bound);
+            if (compress2(dst.data() + header, &bound, src, length, Z_BEST_SPEED) != Z_OK)
+                bound = length; // sent raw
+            dst.resize(header + bound);
+        }
+
+        if ((int)dst.size() < length + 1)
+            return;
+        dst.clear();
+    }
+
+    dst.push_back(CODEC_RAW);
+    dst.insert(dst.end(), src, src + length);
+}
+
+bool MessageCodec::unpack(const uint8_t *src, int length, vector<uint8_t> &scratch,
+                          const uint8_t *&out, int &outLength)
+{
+    if (length < 1)
+        return false;
+
+    const uint8_t *pos = src + 1;
+    const uint8_t *end = src + length;
+    if (src[0] == CODEC_RAW)
+    {
+        out = pos;
+        outLength = length - 1;
+        return true;
+    }
+
+    unsigned original;
+    if (!getVarint(pos, end, original) || original > MAX_MESSAGE_BYTES)
+        return false;
+    scratch.clear();
+
+    if (src[0] == CODEC_LZ)
+    {
+        if (!lzDecompress(pos, end - pos, original, scratch))
+            return false;
+    }
+    else if (src[0] == CODEC_ZLIB)
+    {
+        uLongf size = original;
+        scratch.resize(original);
+        if (uncompress(scratch.data(), &size, pos, end - pos) != Z_OK)
+            return false;
+        scratch.resize(size);
+    }
+    else
+    {
+        return false;
+    }
+
+    if (scratch.size() != original)
+        return false;
+    out = scratch.data();
+    outLength = original;
+    return true;
+}
+
+void MessageCodec::lzCompress(const uint8_t *src, int length, vector<uint8_t> &dst)
+{
+    int table[1 << LZ_HASH_BITS];
+    for (auto &entry : table)
+        entry = -1;
+
+    int anchor = 0; // start of the pending literals
+    int pos = 0;
+    while (pos + LZ_MIN_MATCH <= length)
+    {
+        unsigned h = hashSequence(src + pos);
+        int candidate = table[h];
+        table[h] = pos;
+
+        if (candidate < 0 || pos - candidate > LZ_MAX_OFFSET ||
+            memcmp(src + candidate, src + pos, LZ_MIN_MATCH) != 0)
+        {
+            pos++;
+            continue;
+        }
+
+        int match = LZ_MIN_MATCH;
+        while (pos + match < length && src[candidate + match] == src[pos + match])
+            match++;
+
+        unsigned literals = pos - anchor;
+        unsigned matchCode = match - LZ_MIN_MATCH;
+        dst.push_back((min(literals, 15u) << 4) | min(matchCode, 15u));
+        putLength(dst, literals);
+        dst.insert(dst.end(), src + anchor, src + pos);
+        unsigned offset = pos - candidate;
+        dst.push_back(offset & 0xff);
+        dst.push_back(offset >> 8);
+        putLength(dst, matchCode);
+
+        pos += match;
+        anchor = pos;
+    }
+
+    // The last sequence has literals only
+    unsigned literals = length - anchor;
+    dst.push_back(min(literals, 15u) << 4);
+    putLength(dst, literals);
+    dst.insert(dst.end(), src + anchor, src + length);
+}
+
+bool MessageCodec::lzDecompress(const uint8_t *src, int length, unsigned original,
+                                vector<uint8_t> &dst)
+{
+    dst.reserve(original);
+    const uint8_t *pos = src;
+    const uint8_t *end = src + length;
+    while (pos < end)
+    {
+        uint8_t token = *pos++;
+        unsigned literals = token >> 4;
+        if (!getLength(pos, end, literals) || literals > (unsigned)(end - pos) ||
+            literals > original - dst.size())
+            return false;
+        dst.insert(dst.end(), pos, pos + literals);
+        pos += literals;
+
+        if (pos == end)
+            return true; // last sequence
+
+        if (end - pos < 2)
+            return false;
+        unsigned offset = pos[0] | (pos[1] << 8);
+        pos += 2;
+        unsigned match = token & 0xf;
+        if (!getLength(pos, end, match))
+            return false;
+        match += LZ_MIN_MATCH;
+        if (offset == 0 || offset > dst.size() || match > original - dst.size())
+            return false;
+
+        // Byte by byte, the match may overlap its own output
+        size_t from = dst.size() - offset;
+        for (unsigned i = 0; i < match; i++)
+            dst.push_back(dst[from + i]);
+    }
+    return false;
+}
@@ -0,0 +1,58 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2021
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+/// Codecs of the clause messages, the first byte of a message names it.
+enum MessageCodecType
+{
+    CODEC_RAW = 0,
+    CODEC_LZ = 1,
+    CODEC_ZLIB = 2
+};
+
+// Compression stage of the clause messages. A compressed message is:
+//   [codec] [original length] [compressed bytes]
+// and a raw one:
+//   [CODEC_RAW] [bytes]
+// The in-tree LZ codec is a byte-oriented LZ77 in the spirit of LZ4: each
+// sequence is a token (literal length << 4 | match length - 4), the
+// literals and a 2 bytes offset, lengths of 15 or more continue as varints.
+class MessageCodec
+{
+public:
+    /// Write the message of length bytes to dst with the codec, or raw if
+    /// it does not make the message smaller.
+    static void pack(int codec, const uint8_t *src, int length, vector<uint8_t> &dst);
+
+    /// Read a packed message, out points to src or to scratch. Return false
+    /// if the message is corrupted.
+    static bool unpack(const uint8_t *src, int length, vector<uint8_t> &scratch,
+                       const uint8_t *&out, int &outLength);
+
+private:
+    static void lzCompress(const uint8_t *src, int length, vector<uint8_t> &dst);
+    static bool lzDecompress(const uint8_t *src, int length, unsigned original,
+                             vector<uint8_t> &dst);
+};
@@ -18,19 +18,41 @@
 // -----------------------------------------------------------------------------
 
 #include "../comm/MpiComm.h"
+#include "../working/DistributedDivideAndConquer.h"
 #include "../utils/Parameters.h"
 #include "../utils/Logger.h"
+#include "../utils/System.h"
 
 #include <unistd.h>
 #include <vector>
 #include <cstring>
 #include <cassert>
+#include <algorithm>
+#include <new>
 
 #define REPORT_TAG 1    // worker report to master that it is starving
 #define CUBE_TAG 2      // distribute a cube to a starving worker
 #define CLAUSE_TAG 3    // clause sharing between workers
-#define STOP_TAG 4      // stop solving
+#define STOP_TAG 4      // stop solving: [result] [rank that started the stop]
 #define INTERRUPT_TAG 5 // set/unset interuption of solving
+#define UNIT_TAG 6      // fast lane: [nb units] [units] [binaries]
+#define STEAL_TAG 7     // idle rank asks for a cube, answered by a CUBE_TAG
+#define CLOSED_TAG 8    // cube found UNSAT, to the root: [cube length] [cube]
+
+// clause messages in flight to a peer before the next ones are dropped
+#define MAX_CLAUSE_INFLIGHT 4
+
+// clauses received from a peer before its limits are updated
+#define MIN_FEEDBACK_CLAUSES 32
+
+// percentage of the clauses that passed the filter and were used in a conflict
+// analysis, under (over) which a peer sends less (more), the local producers
+// are judged alike (SHARING_USEFUL_LOW)
+#define LOW_USEFUL_PERCENT 10
+#define HIGH_USEFUL_PERCENT 30
+
+// first lbd limit set to a peer that sends too many useless clauses
+#define LBD_LIMIT_START 8
 
 MpiComm *MpiComm::getInstance()
 {
@@ -38,26 +60,38 @@ MpiComm *MpiComm::getInstance()
     return &ins;
 }
 
-MpiComm::MpiComm()
+MpiComm::MpiComm() :
+    externalFilter(FilterMode(Parameters::getIntParam("shr-filter", FILTER_BLOOM)))
 {
-    int litPerRound = Parameters::getIntParam("shr-lit", 1500);
-    // add 500 (magic number) in order to store splitter '0'
+    litPerRound = Parameters::getIntParam("shr-lit", 1500);
+    stopStarted = false;
+    stopped = false;
+    allStopped = false;
+    // size of the former fixed-size message, only used for statistics
     clauseBufLimit = litPerRound * 2;
-
-    importBuf = (int *)malloc(sizeof(int) * clauseBufLimit);
-    exportBuf = (int *)malloc(sizeof(int) * clauseBufLimit);
 }
 
 MpiComm::~MpiComm()
 {
-    free(importBuf);
-    free(exportBuf);
 }
 
 void MpiComm::init(int rank, int size)
 {
     this->rank = rank;
     this->size = size;
+    clauseInflight.assign(size, 0);
+
+    shrCodec = Parameters::getIntParam("shr-codec", CODEC_RAW);
+    codecMinBytes = Parameters::getIntParam("shr-codec-min", 256);
+
+    PeerLimits noLimits = {litPerRound, 0};
+    exportLimits.assign(size, noLimits);
+    importLimits.assign(size, noLimits);
+    peerStats.resize(size);
+    peerWindow.resize(size);
+    peerUsed.reset(new atomic<unsigned long>[size]);
+    for (int i = 0; i < size; i++)
+        peerUsed[i] = 0;
     int sharingGroupSize = Parameters::getIntParam("shr-group", 0);
     if (sharingGroupSize)
     {
@@ -70,6 +104,175 @@ void MpiComm::init(int rank, int size)
         clsShrLowerRank = 0;
         clsShrUpperRank = size;
     }
+
+    // Control messages are received as soon as they arrive
+    MPI_Recv_init(controlVals[STOP_RECV], 2, MPI_INT, MPI_ANY_SOURCE, STOP_TAG,
+                  MPI_COMM_WORLD, &controlReqs[STOP_RECV]);
+    MPI_Recv_init(controlVals[INTERRUPT_RECV], 1, MPI_INT, MPI_ANY_SOURCE, INTERRUPT_TAG,
+                  MPI_COMM_WORLD, &controlReqs[INTERRUPT_RECV]);
+    MPI_Startall(NB_CONTROL_RECVS, controlReqs);
+
+    // Only the flat topology can use collective operations
+    shrTopo = Parameters::getIntParam("shr-topo", TOPO_FLAT);
+    shrComm = shrTopo == TOPO_FLAT ? Parameters::getIntParam("shr-comm", 0) : 0;
+    if (shrComm == 1)
+    {
+        // One communicator per sharing group for the collective exchange,
+        // and a duplicate for the control messages of the shutdown
+        MPI_Comm_split(MPI_COMM_WORLD, clsShrLowerRank, rank, &groupComm);
+        MPI_Comm_dup(groupComm, &groupCtrlComm);
+        MPI_Comm_rank(groupComm, &groupRank);
+        MPI_Comm_size(groupComm, &groupSize);
+        groupCounts.resize(groupSize);
+        groupDispls.resize(groupSize);
+    }
+
+    if (shrTopo == TOPO_NODE_LEADERS)
+    {
+        initNodeSharing();
+    }
+    else if (shrTopo == TOPO_FLAT)
+    {
+        for (int i = clsShrLowerRank; i < clsShrUpperRank; i++)
+        {
+            if (i != rank)
+                clausePeers.push_back(i);
+        }
+    }
+    else
+    {
+        initGossip();
+    }
+
+    // The solvers wake up the comm thread when they find units or binaries
+    if (FastLane::getInstance()->isEnabled() && size > 1)
+    {
+        FastLane::getInstance()->setListener([this] {
+            laneWork = true;
+            outboxCond.notify_one();
+        });
+    }
+}
+
+void MpiComm::initGossip()
+{
+    // Positions in the sharing group
+    int n = clsShrUpperRank - clsShrLowerRank;
+    int pos = rank - clsShrLowerRank;
+    int dims = 0;
+    while ((1 << dims) < n)
+        dims++;
+
+    int defaultTtl = dims + 1;
+    switch (shrTopo)
+    {
+    case TOPO_RING:
+        for (int next : {(pos + 1) % n, (pos + n - 1) % n})
+        {
+            if (next != pos && find(clausePeers.begin(), clausePeers.end(),
+                                    clsShrLowerRank + next) == clausePeers.end())
+                clausePeers.push_back(clsShrLowerRank + next);
+        }
+        defaultTtl = n / 2;
+        break;
+    case TOPO_HYPERCUBE:
+        for (int d = 1; d < n; d <<= 1)
+        {
+            if ((pos ^ d) < n)
+                clausePeers.push_back(clsShrLowerRank + (pos ^ d));
+        }
+        // Some ranks miss neighbours if the group size is not a power of 2
+        defaultTtl = (1 << dims) == n ? dims : dims + 1;
+        break;
+    case TOPO_RANDOM:
+        for (int i = clsShrLowerRank; i < clsShrUpperRank; i++)
+        {
+            if (i != rank)
+                groupMembers.push_back(i);
+        }
+        fanout = Parameters::getIntParam("shr-fanout", 2);
+        break;
+    default:
+        log(0, "Unknown sharing topology %d, no clause is exchanged\n", shrTopo);
+        break;
+    }
+
+    ttl = max(1, Parameters::getIntParam("shr-ttl", defaultTtl));
+    forwardClauses.resize(ttl - 1);
+}
+
+void MpiComm::pickRandomPeers()
+{
+    // Partial shuffle of the group
+    clausePeers.clear();
+    int k = min(fanout, (int)groupMembers.size());
+    for (int i = 0; i < k; i++)
+    {
+        int j = i + rand() % (groupMembers.size() - i);
+        swap(groupMembers[i], groupMembers[j]);
+        clausePeers.push_back(groupMembers[i]);
+    }
+}
+
+void MpiComm::initNodeSharing()
+{
+    MPI_Comm_split_type(MPI_COMM_WORLD, MPI_COMM_TYPE_SHARED, rank, MPI_INFO_NULL, &nodeComm);
+    MPI_Comm_rank(nodeComm, &nodeRank);
+    MPI_Comm_size(nodeComm, &nodeSize);
+
+    // The first rank of each node is its leader
+    MPI_Comm_split(MPI_COMM_WORLD, nodeRank == 0 ? 0 : MPI_UNDEFINED, rank, &leaderComm);
+
+    int nLeaders = 0;
+    if (nodeRank == 0)
+    {
+        int leaderRank;
+        MPI_Comm_rank(leaderComm, &leaderRank);
+        MPI_Comm_size(leaderComm, &nLeaders);
+        vector<int> leaders(nLeaders);
+        MPI_Allgather(&rank, 1, MPI_INT, leaders.data(), 1, MPI_INT, leaderComm);
+
+        // shr-group counts leaders in this mode
+        int sharingGroupSize = Parameters::getIntParam("shr-group", 0);
+        int lower = 0, upper = nLeaders;
+        if (sharingGroupSize)
+        {
+            lower = leaderRank / sharingGroupSize * sharingGroupSize;
+            upper = min(lower + sharingGroupSize, nLeaders);
+        }
+        for (int i = lower; i < upper; i++)
+        {
+            if (i != leaderRank)
+                clausePeers.push_back(leaders[i]);
+        }
+    }
+    MPI_Bcast(&nLeaders, 1, MPI_INT, 0, nodeComm);
+
+    // A slot holds one packed batch, the one of the leader holds the
+    // batches of its node and the ones of the other leaders
+    int batchCapacity = Parameters::getIntParam("shr-lit", 1500) * 16 + 1024;
+    int capacity = batchCapacity;
+    if (nodeRank == 0)
+        capacity = batchCapacity * nodeSize * (nLeaders + 1);
+
+    uint8_t *base;
+    MPI_Win_allocate_shared(sizeof(NodeSlot) + capacity, 1, MPI_INFO_NULL, nodeComm, &base, &nodeWin);
+    new (base) NodeSlot();
+    MPI_Win_lock_all(MPI_MODE_NOCHECK, nodeWin);
+    MPI_Barrier(nodeComm);
+
+    nodeSlots.resize(nodeSize);
+    slotCapacity.resize(nodeSize);
+    lastSeq.assign(nodeSize, 0);
+    for (int i = 0; i < nodeSize; i++)
+    {
+        MPI_Aint bytes;
+        int dispUnit;
+        MPI_Win_shared_query(nodeWin, i, &bytes, &dispUnit, &nodeSlots[i]);
+        slotCapacity[i] = bytes - sizeof(NodeSlot);
+    }
+
+    log(1, "Rank %d is rank %d of a node of %d, %d leaders\n", rank, nodeRank, nodeSize, nLeaders);
 }
 
 void MpiComm::addClausesToExternal(const vector<ClauseExchange *> &clauses)
@@ -95,40 +298,570 @@ void MpiComm::getClausesFromExternal(vector<ClauseExchange *> &clauses)
 }
 
 void MpiComm::exportLearnedClauses()
+{
+    if (shrTopo == TOPO_NODE_LEADERS)
+        exchangeHierarchical();
+    else if (shrComm == 1)
+        exchangeCollective();
+    else
+        exchangePointToPoint();
+}
+
+int MpiComm::selectBatch(vector<uint8_t> &buf)
 {
     std::vector<ClauseExchange *> tmp;
     int selectCount;
     // Get shortest clauses from database
-    int used = clausesToExport.giveSelection(tmp, Parameters::getIntParam("shr-lit", 1500), &selectCount);
-    if (tmp.empty())
-        return;
+    clausesToExport.giveSelection(tmp, litPerRound, &selectCount);
+
+    buf.clear();
+    ClauseCodec::encode(tmp, buf);
 
-    int idx = 1;
     for (auto cls : tmp)
     {
-        for (int i = 0; i < cls->size; i++)
+        ClauseManager::releaseClause(cls);
+    }
+    return tmp.size();
+}
+
+void MpiComm::exchangePointToPoint()
+{
+    if (shrTopo == TOPO_RANDOM)
+        pickRandomPeers();
+
+    // Own clauses, then the remote ones to forward
+    vector<vector<ClauseExchange *>> sections(ttl);
+    int selectCount;
+    clausesToExport.giveSelection(sections[0], groupLimits(clausePeers).budget, &selectCount);
+    for (int hop = 1; hop < ttl; hop++)
+    {
+        forwardClauses[hop - 1].giveSelection(sections[hop], litPerRound, &selectCount);
+    }
+
+    sendToGroup(sections);
+
+    for (auto &section : sections)
+    {
+        for (auto cls : section)
         {
-            exportBuf[idx++] = cls->lits[i];
+            ClauseManager::releaseClause(cls);
         }
-        exportBuf[idx++] = 0;
     }
-    idx--;
-    exportBuf[0] = idx;
-    assert(idx < clauseBufLimit);
-    for (int i = clsShrLowerRank; i < clsShrUpperRank; i++)
+}
+
+void MpiComm::sendToGroup(vector<vector<ClauseExchange *>> &sections)
+{
+    int nSelected = 0;
+    for (auto &section : sections)
+    {
+        stable_sort(section.begin(), section.end(),
+                    [](ClauseExchange *a, ClauseExchange *b) { return a->size < b->size; });
+        nSelected += section.size();
+    }
+    if (nSelected == 0)
+        return;
+
+    // Peers with the same limits get the same clauses, a peer that does not
+    // receive fast enough misses the round
+    PeerLimits last = {-1, -1};
+    int nClauses = 0;
+    int nPeers = 0;
+    for (int peer : clausePeers)
     {
-        if (i == rank)
+        if (clauseInflight[peer] >= MAX_CLAUSE_INFLIGHT)
+        {
+            stats.messagesDropped++;
             continue;
-        MPI_Bsend(exportBuf, clauseBufLimit, MPI_INT, i, CLAUSE_TAG, MPI_COMM_WORLD);
+        }
+
+        PeerLimits &limits = exportLimits[peer];
+        if (limits.budget != last.budget || limits.lbdLimit != last.lbdLimit)
+        {
+            exportBuf.clear();
+            nClauses = encodeSections(sections, limits, exportBuf);
+            last = limits;
+        }
+        if (nClauses == 0)
+            continue;
+
+        PendingSend send;
+        messageBuf.clear();
+        appendFeedback(vector<int>(1, peer), messageBuf);
+        messageBuf.insert(messageBuf.end(), exportBuf.begin(), exportBuf.end());
+        send.data = make_shared<vector<uint8_t>>();
+        packMessage(messageBuf, *send.data);
+        send.type = MPI_UNSIGNED_CHAR;
+        send.count = send.data->size();
+        send.dest = peer;
+        send.tag = CLAUSE_TAG;
+        startSend(send);
+
+        nPeers++;
+        stats.messagesSent++;
+        stats.clausesSent += nClauses;
+        stats.bytesSent += send.count;
+        stats.fixedFormatBytes += clauseBufLimit * sizeof(int);
     }
 
-    for (auto cls : tmp)
+    if (nPeers)
+        stats.rounds++;
+    log(2, "Rank %d exports up to %d clauses to %d peers\n",
+        rank, nSelected, nPeers);
+}
+
+void MpiComm::packMessage(const vector<uint8_t> &message, vector<uint8_t> &packed)
+{
+    int codec = (int)message.size() >= codecMinBytes ? shrCodec : CODEC_RAW;
+    double start = getAbsoluteTime();
+    MessageCodec::pack(codec, message.data(), message.size(), packed);
+    if (codec != CODEC_RAW)
+        stats.codecTime += getAbsoluteTime() - start;
+    stats.codecBytesSaved += message.size() + 1 - packed.size();
+}
+
+int MpiComm::encodeSections(vector<vector<ClauseExchange *>> &sections,
+                            const PeerLimits &limits, vector<uint8_t> &buf)
+{
+    int nClauses = 0;
+    for (size_t hop = 0; hop < sections.size(); hop++)
+    {
+        sectionBuf.clear();
+        int n = encodeWithin(sections[hop], limits, sectionBuf);
+        if (n == 0)
+            continue;
+        ClauseCodec::encodeSectionHeader(hop, sectionBuf.size(), buf);
+        buf.insert(buf.end(), sectionBuf.begin(), sectionBuf.end());
+        nClauses += n;
+    }
+    return nClauses;
+}
+
+MpiComm::PeerLimits MpiComm::groupLimits(const vector<int> &peers)
+{
+    // The loosest limits of the peers
+    PeerLimits limits = {0, -1};
+    for (int peer : peers)
+    {
+        limits.budget = max(limits.budget, exportLimits[peer].budget);
+        if (exportLimits[peer].lbdLimit == 0 || limits.lbdLimit == -1)
+            limits.lbdLimit = exportLimits[peer].lbdLimit;
+        else if (limits.lbdLimit)
+            limits.lbdLimit = max(limits.lbdLimit, exportLimits[peer].lbdLimit);
+    }
+    if (limits.lbdLimit == -1)
+        limits.lbdLimit = 0;
+    return limits;
+}
+
+void MpiComm::updateImportLimits(int peer)
+{
+    PeerStatistics &total = peerStats[peer];
+    PeerStatistics &window = peerWindow[peer];
+    total.used = peerUsed[peer];
+
+    unsigned long received = total.received - window.received;
+    if (received < MIN_FEEDBACK_CLAUSES)
+        return;
+    unsigned long accepted = total.accepted - window.accepted;
+    unsigned long useful = min(total.used - window.used, accepted);
+
+    // As HordeSat does for the production of the local solvers, but the
+    // clauses of a peer are judged by the solvers of this rank: a peer whose
+    // clauses are all duplicates has no useful one
+    PeerLimits &limits = importLimits[peer];
+    if (useful * 100 < accepted * LOW_USEFUL_PERCENT || accepted == 0)
+    {
+        limits.budget = max(limits.budget * 3 / 4, litPerRound / 8);
+        limits.lbdLimit = limits.lbdLimit ? max(limits.lbdLimit - 1, 2) : LBD_LIMIT_START;
+    }
+    else if (useful * 100 > accepted * HIGH_USEFUL_PERCENT)
+    {
+        limits.budget = min(limits.budget * 5 / 4 + 1, litPerRound);
+        if (limits.lbdLimit && ++limits.lbdLimit > LBD_LIMIT_START)
+            limits.lbdLimit = 0;
+    }
+    window = total;
+}
+
+void MpiComm::appendFeedback(const vector<int> &peers, vector<uint8_t> &buf)
+{
+    feedback.clear();
+    for (int peer : peers)
+    {
+        updateImportLimits(peer);
+        feedback.push_back({peer, importLimits[peer].budget, importLimits[peer].lbdLimit});
+    }
+    ClauseCodec::encodeFeedback(feedback, buf);
+}
+
+int MpiComm::encodeWithin(vector<ClauseExchange *> &batch, const PeerLimits &limits,
+                          vector<uint8_t> &buf)
+{
+    // The batch is sorted by size, the shortest clauses are kept
+    selected.clear();
+    int used = 0;
+    for (auto cls : batch)
+    {
+        if (limits.lbdLimit && cls->lbd > limits.lbdLimit)
+            continue;
+        if (used + cls->size > limits.budget)
+            break;
+        used += cls->size;
+        selected.push_back(cls);
+    }
+    ClauseCodec::encode(selected, buf);
+    return selected.size();
+}
+
+int MpiComm::selectGroupBatch(vector<uint8_t> &buf)
+{
+    PeerLimits limits = groupLimits(clausePeers);
+
+    vector<ClauseExchange *> batch;
+    int selectCount;
+    clausesToExport.giveSelection(batch, limits.budget, &selectCount);
+
+    messageBuf.clear();
+    appendFeedback(clausePeers, messageBuf);
+    stable_sort(batch.begin(), batch.end(),
+                [](ClauseExchange *a, ClauseExchange *b) { return a->size < b->size; });
+    sectionBuf.clear();
+    int nClauses = encodeWithin(batch, limits, sectionBuf);
+    if (nClauses)
+    {
+        ClauseCodec::encodeSectionHeader(0, sectionBuf.size(), messageBuf);
+        messageBuf.insert(messageBuf.end(), sectionBuf.begin(), sectionBuf.end());
+    }
+    packMessage(messageBuf, buf);
+
+    for (auto cls : batch)
     {
         ClauseManager::releaseClause(cls);
     }
+    return nClauses;
+}
+
+void MpiComm::exchangeCollective()
+{
+    if (groupSize == 1)
+        return;
+
+    // Each round is an allgather of the batch sizes followed by an
+    // allgatherv of the batches. The batch of the next round is selected
+    // while the current one is in flight.
+    int done = 1;
+    if (groupReq != MPI_REQUEST_NULL)
+        MPI_Test(&groupReq, &done, MPI_STATUS_IGNORE);
+
+    if (done && groupPhase == GROUP_SIZES)
+    {
+        int total = 0;
+        for (int i = 0; i < groupSize; i++)
+        {
+            groupDispls[i] = total;
+            total += groupCounts[i];
+        }
+        gatherBuf.resize(total);
+        postGroupStep();
+        MPI_Test(&groupReq, &done, MPI_STATUS_IGNORE);
+    }
+
+    if (done && groupPhase == GROUP_DATA)
+    {
+        for (int i = 0; i < groupSize; i++)
+        {
+            if (i == groupRank || groupCounts[i] == 0)
+                continue;
+            stats.bytesReceived += groupCounts[i];
+            // The group keeps the order of the world ranks
+            handleReceivedClauses(gatherBuf.data() + groupDispls[i], groupCounts[i],
+                                  clsShrLowerRank + i);
+        }
+        groupPhase = GROUP_IDLE;
+    }
+
+    if (groupPhase == GROUP_IDLE)
+    {
+        if (!nextBatchReady)
+            nextBatchSize = selectGroupBatch(nextBatch);
+        swap(exportBuf, nextBatch);
+        int nClauses = nextBatchSize;
+        nextBatchReady = false;
+
+        postGroupStep();
+        MPI_Test(&groupReq, &done, MPI_STATUS_IGNORE);
+
+        stats.rounds++;
+        stats.messagesSent += groupSize - 1;
+        stats.clausesSent += (unsigned long)nClauses * (groupSize - 1);
+        stats.bytesSent += (unsigned long)exportBuf.size() * (groupSize - 1);
+        stats.fixedFormatBytes += (unsigned long)clauseBufLimit * sizeof(int) * (groupSize - 1);
+        log(2, "Rank %d exports %d clauses in %d bytes to its group\n",
+            rank, nClauses, (int)exportBuf.size());
+    }
+
+    if (!nextBatchReady)
+    {
+        nextBatchSize = selectGroupBatch(nextBatch);
+        nextBatchReady = true;
+    }
+}
+
+void MpiComm::postGroupStep()
+{
+    if (groupPhase == GROUP_SIZES)
+    {
+        MPI_Iallgatherv(exportBuf.data(), exportBuf.size(), MPI_UNSIGNED_CHAR,
+                        gatherBuf.data(), groupCounts.data(), groupDispls.data(),
+                        MPI_UNSIGNED_CHAR, groupComm, &groupReq);
+        groupPhase = GROUP_DATA;
+    }
+    else
+    {
+        exportSize = exportBuf.size();
+        MPI_Iallgather(&exportSize, 1, MPI_INT, groupCounts.data(), 1, MPI_INT,
+                       groupComm, &groupReq);
+        groupPhase = GROUP_SIZES;
+    }
+    groupSteps++;
+}
+
+void MpiComm::exchangeHierarchical()
+{
+    if (nodeRank != 0)
+    {
+        // Publish the batch to the leader and take what it fans out, the
+        // leader already filtered it
+        selectBatch(exportBuf);
+        writeSlot(exportBuf);
+
+        if (!readSlot(0, slotBuf))
+            return;
+
+        // [source node rank] [length] [packed clauses] ...
+        size_t pos = 0;
+        while (pos + 2 * sizeof(int) <= slotBuf.size())
+        {
+            int source, length;
+            memcpy(&source, &slotBuf[pos], sizeof(int));
+            memcpy(&length, &slotBuf[pos + sizeof(int)], sizeof(int));
+            pos += 2 * sizeof(int);
+            if (length < 0 || pos + length > slotBuf.size())
+            {
+                log(0, "Rank %d read a corrupted node slot\n", rank);
+                break;
+            }
+            if (source != nodeRank)
+                handleReceivedClauses(&slotBuf[pos], length, -1, false);
+            pos += length;
+        }
+        return;
+    }
+
+    // The clauses of the node, by node rank, the remote ones come last
+    vector<vector<ClauseExchange *>> sources(nodeSize + 1);
+
+    int selectCount;
+    clausesToExport.giveSelection(sources[0], litPerRound, &selectCount);
+    for (int i = 1; i < nodeSize; i++)
+    {
+        if (readSlot(i, slotBuf))
+            handleReceivedClauses(slotBuf.data(), slotBuf.size(), -1, true, &sources[i]);
+    }
+
+    // The node batch goes to the other leaders
+    vector<vector<ClauseExchange *>> nodeBatch(1);
+    for (int i = 0; i < nodeSize; i++)
+        nodeBatch[0].insert(nodeBatch[0].end(), sources[i].begin(), sources[i].end());
+    sendToGroup(nodeBatch);
+
+    // Fan out to the node everything the leader accepted since last round
+    sources[nodeSize].swap(remoteAccepted);
+    slotBuf.clear();
+    for (int i = 0; i <= nodeSize; i++)
+    {
+        if (sources[i].empty())
+            continue;
+
+        size_t header = slotBuf.size();
+        slotBuf.resize(header + 2 * sizeof(int));
+        ClauseCodec::encode(sources[i], slotBuf);
+        int length = slotBuf.size() - header - 2 * sizeof(int);
+        if ((int)slotBuf.size() > slotCapacity[0])
+        {
+            // Should not happen with the computed capacity
+            log(0, "Rank %d drops %d clauses to fan out\n", rank, (int)sources[i].size());
+            slotBuf.resize(header);
+        }
+        else
+        {
+            memcpy(&slotBuf[header], &i, sizeof(int));
+            memcpy(&slotBuf[header + sizeof(int)], &length, sizeof(int));
+        }
+
+        for (auto cls : sources[i])
+            ClauseManager::releaseClause(cls);
+    }
+    writeSlot(slotBuf);
+}
+
+void MpiComm::writeSlot(const vector<uint8_t> &buf)
+{
+    NodeSlot *slot = nodeSlots[nodeRank];
+    if ((int)buf.size() > slotCapacity[nodeRank])
+    {
+        log(0, "Rank %d: batch of %d bytes does not fit in its node slot\n", rank, (int)buf.size());
+        return;
+    }
+
+    unsigned long seq = slot->seq.load(memory_order_relaxed);
+    slot->seq.store(seq + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    memcpy(slot->data, buf.data(), buf.size());
+    slot->length = buf.size();
+    slot->seq.store(seq + 2, memory_order_release);
+    MPI_Win_sync(nodeWin);
+
+    stats.nodeBytes += buf.size();
+}
+
+bool MpiComm::readSlot(int nodePeer, vector<uint8_t> &buf)
+{
+    NodeSlot *slot = nodeSlots[nodePeer];
+    MPI_Win_sync(nodeWin);
+
+    // A round is lost if the owner writes twice in between, as for any
+    // clause that does not fit in a message
+    for (int retry = 0; retry < 3; retry++)
+    {
+        unsigned long seq = slot->seq.load(memory_order_acquire);
+        if (seq == lastSeq[nodePeer])
+            return false;
+        if (seq & 1)
+            continue;
+
+        int length = slot->length;
+        if (length < 0 || length > slotCapacity[nodePeer])
+            continue;
+        buf.assign(slot->data, slot->data + length);
+        atomic_thread_fence(memory_order_acquire);
+        if (slot->seq.load(memory_order_relaxed) != seq)
+            continue;
+
+        lastSeq[nodePeer] = seq;
+        stats.nodeBytes += length;
+        return true;
+    }
+    return false;
+}
+
+void MpiComm::finishClauseExchange()
+{
+    if (nodeWin != MPI_WIN_NULL)
+    {
+        // MPI_Win_free synchronizes the node
+        MPI_Request req;
+        MPI_Ibarrier(nodeComm, &req);
+        waitWithProgress(req);
+        MPI_Win_unlock_all(nodeWin);
+        MPI_Win_free(&nodeWin);
+    }
+
+    if (shrComm != 1 || groupSize == 1)
+        return;
+
+    // Ranks stop at different rounds, the late ones post empty rounds until
+    // every rank of the group has posted the same collective operations.
+    long maxSteps;
+    MPI_Request req;
+    MPI_Iallreduce(&groupSteps, &maxSteps, 1, MPI_LONG, MPI_MAX, groupCtrlComm, &req);
+    waitWithProgress(req);
+
+    while (groupSteps < maxSteps || groupReq != MPI_REQUEST_NULL)
+    {
+        waitWithProgress(groupReq);
+
+        if (groupPhase == GROUP_SIZES)
+        {
+            int total = 0;
+            for (int i = 0; i < groupSize; i++)
+            {
+                groupDispls[i] = total;
+                total += groupCounts[i];
+            }
+            gatherBuf.resize(total);
+        }
+
+        if (groupSteps < maxSteps)
+        {
+            // Finishing a round keeps the announced size of the batch
+            if (groupPhase != GROUP_SIZES)
+                exportBuf.clear();
+            postGroupStep();
+        }
+    }
+    groupPhase = GROUP_IDLE;
 }
 
 void MpiComm::cleanReceivingBuffer()
+{
+    // Complete the sends while receiving the messages of the other ranks,
+    // then wait for all of them to do so. The stops are forwarded until every
+    // rank got here, a second round completes the last forwarded ones.
+    for (int round = 0; round < 2; round++)
+    {
+        MPI_Request barrier = MPI_REQUEST_NULL;
+        int barrierDone = 0;
+        while (!barrierDone)
+        {
+            pollControl();
+            discardIncoming();
+            flushOutbox();
+            reapSends();
+            if (barrier == MPI_REQUEST_NULL && inflight.empty())
+            {
+                MPI_Ibarrier(MPI_COMM_WORLD, &barrier);
+            }
+            if (barrier != MPI_REQUEST_NULL)
+            {
+                MPI_Test(&barrier, &barrierDone, MPI_STATUS_IGNORE);
+            }
+        }
+        allStopped = true;
+    }
+
+    for (int i = 0; i < NB_CONTROL_RECVS; i++)
+    {
+        MPI_Cancel(&controlReqs[i]);
+        MPI_Wait(&controlReqs[i], MPI_STATUS_IGNORE);
+        MPI_Request_free(&controlReqs[i]);
+    }
+    discardIncoming();
+}
+
+void MpiComm::barrier()
+{
+    MPI_Request req;
+    MPI_Ibarrier(MPI_COMM_WORLD, &req);
+    waitWithProgress(req);
+}
+
+void MpiComm::waitWithProgress(MPI_Request &req)
+{
+    // The stops are still forwarded to the ranks that wait for them
+    int done = 0;
+    while (true)
+    {
+        MPI_Test(&req, &done, MPI_STATUS_IGNORE);
+        if (done)
+            break;
+        pollControl();
+        reapSends();
+        usleep(100);
+    }
+}
+
+void MpiComm::discardIncoming()
 {
     int received;
     MPI_Status s;
@@ -136,14 +869,15 @@ void MpiComm::cleanReceivingBuffer()
     while (!receiveDone)
     {
         MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &received, &s);
-        if (received)
+        if (received && s.MPI_TAG == STOP_TAG)
+        {
+            int stop[2];
+            MPI_Recv(stop, 2, MPI_INT, s.MPI_SOURCE, s.MPI_TAG, MPI_COMM_WORLD, &s);
+            handleStop(stop[0], stop[1]);
+        }
+        else if (received)
         {
-            int *garbage;
-            int length;
-            MPI_Get_count(&s, MPI_INT, &length);
-            garbage = (int *)malloc(length * sizeof(int));
-            MPI_Recv(garbage, length, MPI_INT, s.MPI_SOURCE, s.MPI_TAG, MPI_COMM_WORLD, &s);
-            free(garbage);
+            discardMessage(s);
         }
         else
         {
@@ -152,8 +886,197 @@ void MpiComm::cleanReceivingBuffer()
     }
 }
 
-SatResult MpiComm::receiveIncomingMsg()
+void MpiComm::postSend(const int *vals, int count, int dest, int tag)
+{
+    PendingSend send;
+    send.data = make_shared<vector<uint8_t>>((const uint8_t *)vals, (const uint8_t *)(vals + count));
+    send.type = MPI_INT;
+    send.count = count;
+    send.dest = dest;
+    send.tag = tag;
+
+    {
+        lock_guard<mutex> guard(outboxLock);
+        outbox.push_back(send);
+    }
+    outboxCond.notify_one();
+}
+
+void MpiComm::waitForWork(int usec)
+{
+    unique_lock<mutex> lock(outboxLock);
+    if (outbox.empty() && !laneWork)
+        outboxCond.wait_for(lock, chrono::microseconds(usec));
+}
+
+bool MpiComm::flushOutbox()
+{
+    vector<PendingSend> sends;
+    {
+        lock_guard<mutex> guard(outboxLock);
+        sends.swap(outbox);
+    }
+
+    for (auto &send : sends)
+    {
+        startSend(send);
+    }
+    reapSends();
+
+    return !sends.empty();
+}
+
+void MpiComm::startSend(const PendingSend &send)
 {
+    MPI_Request req;
+    MPI_Isend(send.data->data(), send.count, send.type, send.dest, send.tag, MPI_COMM_WORLD, &req);
+    inflight.push_back(send);
+    inflightReqs.push_back(req);
+    if (send.tag == CLAUSE_TAG)
+        clauseInflight[send.dest]++;
+}
+
+void MpiComm::reapSends()
+{
+    if (inflightReqs.empty())
+        return;
+
+    int nDone;
+    vector<int> indices(inflightReqs.size());
+    MPI_Testsome(inflightReqs.size(), inflightReqs.data(), &nDone, indices.data(), MPI_STATUSES_IGNORE);
+    if (nDone == MPI_UNDEFINED || nDone == 0)
+        return;
+
+    // Completed requests are set to MPI_REQUEST_NULL, keep the others
+    for (int i = 0; i < nDone; i++)
+    {
+        PendingSend &send = inflight[indices[i]];
+        if (send.tag == CLAUSE_TAG)
+            clauseInflight[send.dest]--;
+        send.data.reset();
+    }
+    size_t kept = 0;
+    for (size_t i = 0; i < inflightReqs.size(); i++)
+    {
+        if (inflightReqs[i] == MPI_REQUEST_NULL)
+            continue;
+        inflightReqs[kept] = inflightReqs[i];
+        inflight[kept] = inflight[i];
+        kept++;
+    }
+    inflightReqs.resize(kept);
+    inflight.resize(kept);
+}
+
+bool MpiComm::pollControl()
+{
+    int nDone;
+    int indices[NB_CONTROL_RECVS];
+    MPI_Status statuses[NB_CONTROL_RECVS];
+    MPI_Testsome(NB_CONTROL_RECVS, controlReqs, &nDone, indices, statuses);
+    for (int i = 0; i < nDone && nDone != MPI_UNDEFINED; i++)
+    {
+        int idx = indices[i];
+        if (idx == STOP_RECV)
+            handleStop(controlVals[idx][0], controlVals[idx][1]);
+        else if (globalEnding == false)
+            handleInterrupt(controlVals[idx][0], statuses[i].MPI_SOURCE);
+        MPI_Start(&controlReqs[idx]);
+    }
+    flushOutbox();
+    return nDone > 0;
+}
+
+void MpiComm::handleUnits(MPI_Status &s)
+{
+    FastLane *lane = FastLane::getInstance();
+
+    int length;
+    MPI_Get_count(&s, MPI_INT, &length);
+    vector<int> lits(length);
+    MPI_Recv(lits.data(), length, MPI_INT, s.MPI_SOURCE, UNIT_TAG, MPI_COMM_WORLD, &s);
+
+    int nbUnits = lits[0];
+    for (int i = 1; i < length;)
+    {
+        int clsSize = i <= nbUnits ? 1 : 2;
+        ClauseExchange *cls = ClauseManager::allocClause(clsSize);
+        cls->lbd = clsSize;
+        cls->from = remoteOrigin(s.MPI_SOURCE);
+        std::copy(&lits[i], &lits[i] + clsSize, cls->lits);
+        i += clsSize;
+
+        stats.laneReceived++;
+        if (!lane->publish(cls))
+            clausesToImport.addClause(cls);
+    }
+}
+
+bool MpiComm::exchangeFastLane()
+{
+    FastLane *lane = FastLane::getInstance();
+    if (!lane->isEnabled() || size == 1)
+        return false;
+
+    bool activity = false;
+
+    // Probed first, the units prune the search of all the local solvers
+    int received;
+    MPI_Status s;
+    MPI_Iprobe(MPI_ANY_SOURCE, UNIT_TAG, MPI_COMM_WORLD, &received, &s);
+    while (received)
+    {
+        activity = true;
+        handleUnits(s);
+        MPI_Iprobe(MPI_ANY_SOURCE, UNIT_TAG, MPI_COMM_WORLD, &received, &s);
+    }
+
+    // The local clauses published since the last call
+    laneWork = false;
+    vector<int> msg(1, 0);
+    for (int l = 0; l < 2; l++)
+    {
+        ClauseExchange *cls;
+        while ((cls = lane->get(l == 0, laneSent[l])) != NULL)
+        {
+            laneSent[l]++;
+            if (cls->from < 0)
+                continue; // from another rank
+            msg.insert(msg.end(), cls->lits, cls->lits + cls->size);
+            if (l == 0)
+                msg[0]++;
+        }
+    }
+
+    if (msg.size() == 1 || globalEnding)
+        return activity;
+
+    for (int i = clsShrLowerRank; i < clsShrUpperRank; i++)
+    {
+        if (i != rank)
+        {
+            postSend(msg.data(), msg.size(), i, UNIT_TAG);
+            stats.laneSent += msg[0] + (msg.size() - 1 - msg[0]) / 2;
+        }
+    }
+
+    return true;
+}
+
+bool MpiComm::receiveIncomingMsg()
+{
+    bool activity = exchangeFastLane();
+    activity |= flushOutbox();
+    activity |= pollControl();
+
+    // Progress the pending collective exchange between two rounds
+    if (groupReq != MPI_REQUEST_NULL)
+    {
+        int done;
+        MPI_Test(&groupReq, &done, MPI_STATUS_IGNORE);
+    }
+
+    // Messages of variable size are probed
     int received;
     MPI_Status s;
     bool receiveDone = false;
@@ -162,8 +1085,9 @@ SatResult MpiComm::receiveIncomingMsg()
         MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &received, &s);
         if (received)
         {
+            activity = true;
             int tag = s.MPI_TAG;
-            if (globalEnding) tag = -1;
+            if (globalEnding && tag != STOP_TAG) tag = -1;
             switch (tag)
             {
             case REPORT_TAG:
@@ -171,15 +1095,16 @@ SatResult MpiComm::receiveIncomingMsg()
                 assert(rank == 0);
                 int length;
                 MPI_Get_count(&s, MPI_INT, &length);
-                // FIXME: free the result
-                int* result = (int*) malloc(sizeof(int) * length);
-                MPI_Recv(result, length, MPI_INT, s.MPI_SOURCE, s.MPI_TAG, MPI_COMM_WORLD, &s);
+                vector<int> result(length);
+                MPI_Recv(result.data(), length, MPI_INT, s.MPI_SOURCE, s.MPI_TAG, MPI_COMM_WORLD, &s);
                 log(1, "root receives result %d from rank %d\n", result[0], s.MPI_SOURCE);
-                if (res && s.MPI_SOURCE != 0)
+                // The result of the root itself is already claimed
+                SatResult expected = UNKNOWN;
+                if (!res.compare_exchange_strong(expected, SatResult(result[0])) &&
+                    s.MPI_SOURCE != 0)
                 {
                     break;
                 }
-                res = SatResult(result[0]);
                 if (length > 1)
                 {
                     model.clear();
@@ -188,7 +1113,7 @@ SatResult MpiComm::receiveIncomingMsg()
                         model.push_back(result[i]);
                     }
                 }
-                this->parentStrategy[s.MPI_SOURCE]->join(parentStrategy[s.MPI_SOURCE], res, model);
+                this->parentStrategy[s.MPI_SOURCE]->join(parentStrategy[s.MPI_SOURCE], res.load(), model);
                 break;
             }
             case CUBE_TAG:
@@ -206,52 +1131,74 @@ SatResult MpiComm::receiveIncomingMsg()
                     }
                 }
 
+                // Answer to a steal request, a negative length for no cube
+                if (stealingStrategy)
+                {
+                    stealingStrategy->stealAnswer(branchBuf[0] >= 0, cube);
+                    break;
+                }
+
                 log(1, "Rank %d receives solve with cube size %d\n", rank, (int)cube.size());
                 this->childStrategy->solve(cube);
                 break;
             }
+            case STEAL_TAG:
+            {
+                int victim;
+                MPI_Recv(&victim, 1, MPI_INT, s.MPI_SOURCE, s.MPI_TAG, MPI_COMM_WORLD, &s);
+                if (stealingStrategy)
+                    stealingStrategy->stealRequest(s.MPI_SOURCE);
+                else
+                    sendNoCube(s.MPI_SOURCE);
+                break;
+            }
+            case CLOSED_TAG:
+            {
+                assert(rank == 0);
+                int length;
+                MPI_Get_count(&s, MPI_INT, &length);
+                vector<int> closed(length);
+                MPI_Recv(closed.data(), length, MPI_INT, s.MPI_SOURCE, s.MPI_TAG, MPI_COMM_WORLD, &s);
+                if (stealingStrategy)
+                    stealingStrategy->closeCube(vector<int>(closed.begin() + 1, closed.end()));
+                break;
+            }
             case CLAUSE_TAG:
             {
-                MPI_Recv(importBuf, clauseBufLimit, MPI_INT, s.MPI_SOURCE, s.MPI_TAG, MPI_COMM_WORLD, &s);
-                handleReceivedClauses(importBuf, clauseBufLimit);
+                int length;
+                MPI_Get_count(&s, MPI_UNSIGNED_CHAR, &length);
+                importBuf.resize(length);
+                MPI_Recv(importBuf.data(), length, MPI_UNSIGNED_CHAR, s.MPI_SOURCE, s.MPI_TAG, MPI_COMM_WORLD, &s);
+                stats.bytesReceived += length;
+                // A leader fans the remote clauses out to its node
+                handleReceivedClauses(importBuf.data(), length, s.MPI_SOURCE, true,
+                                      shrTopo == TOPO_NODE_LEADERS ? &remoteAccepted : NULL);
                 break;
             }
-            // TODO: should this update globalEnding?
             case STOP_TAG:
             {
-                int ret;
-                MPI_Recv(&ret, 1, MPI_INT, s.MPI_SOURCE, s.MPI_TAG, MPI_COMM_WORLD, &s);
-                assert(s.MPI_SOURCE == 0);
-                log(1, "%d receives result %d from root\n", this->rank, ret);
-                res = SatResult(ret);
-                globalEnding = true;
+                int stop[2];
+                MPI_Recv(stop, 2, MPI_INT, s.MPI_SOURCE, s.MPI_TAG, MPI_COMM_WORLD, &s);
+                handleStop(stop[0], stop[1]);
+                break;
+            }
+            case UNIT_TAG:
+            {
+                // Sent once, a fast lane message arrived since the probe of
+                // exchangeFastLane must not be lost
+                handleUnits(s);
                 break;
             }
             case INTERRUPT_TAG:
             {
                 int ret;
                 MPI_Recv(&ret, 1, MPI_INT, s.MPI_SOURCE, s.MPI_TAG, MPI_COMM_WORLD, &s);
-                assert(s.MPI_SOURCE == 0);
-                if (ret)
-                {
-                    log(1, "%d receives setInterrupt from root\n", this->rank);
-                    this->childStrategy->setInterrupt();
-                }
-                else
-                {
-                    log(1, "%d receives unsetInterrupt from root\n", this->rank);
-                    this->childStrategy->unsetInterrupt();
-                }
+                handleInterrupt(ret, s.MPI_SOURCE);
                 break;
             }
             default:
                 log(1, "garbage is received from rank %d with tag %d\n", rank, s.MPI_TAG);
-                int *garbage;
-                int length;
-                MPI_Get_count(&s, MPI_INT, &length);
-                garbage = (int *)malloc(length * sizeof(int));
-                MPI_Recv(garbage, length, MPI_INT, s.MPI_SOURCE, s.MPI_TAG, MPI_COMM_WORLD, &s);
-                free(garbage);
+                discardMessage(s);
                 break;
             }
         }
@@ -260,88 +1207,266 @@ SatResult MpiComm::receiveIncomingMsg()
             receiveDone = true;
         }
     }
-    return res;
+    return activity;
 }
 
-void MpiComm::handleReceivedClauses(int *clsBuf, int size)
+void MpiComm::handleStop(int ret, int root)
 {
-    int length = clsBuf[0];
-    assert(length < size);
-    vector<int> tmp;
-    for (int i = 1; i <= length; i++)
+    // Every stop is forwarded, several ranks may have started one
+    if (!allStopped)
+        sendStop(ret, root);
+
+    if (stopped)
+        return;
+    stopped = true;
+    log(1, "%d receives result %d started by rank %d\n", this->rank, ret, root);
+
+    if (childStrategy)
+        childStrategy->setInterrupt();
+
+    // The root ends once it has the model
+    if (rank != 0)
+    {
+        SatResult expected = UNKNOWN;
+        res.compare_exchange_strong(expected, SatResult(ret));
+        globalEnding = true;
+    }
+}
+
+void MpiComm::sendStop(int ret, int root)
+{
+    // Binomial tree rooted at root: the rank at distance rel gets the stop
+    // from rel - lowbit(rel) and sends it to rel + mask for mask < lowbit(rel)
+    int rel = (rank - root + size) % size;
+    int lowbit = rel & -rel;
+    if (rel == 0)
+    {
+        lowbit = 1;
+        while (lowbit < size)
+            lowbit <<= 1;
+    }
+
+    int stop[2] = {ret, root};
+    for (int mask = lowbit >> 1; mask > 0; mask >>= 1)
+    {
+        if (rel + mask < size)
+            postSend(stop, 2, (rel + mask + root) % size, STOP_TAG);
+    }
+}
+
+void MpiComm::handleInterrupt(int ret, int source)
+{
+    assert(source == 0);
+    if (ret)
+    {
+        log(1, "%d receives setInterrupt from root\n", this->rank);
+        this->childStrategy->setInterrupt();
+    }
+    else
+    {
+        log(1, "%d receives unsetInterrupt from root\n", this->rank);
+        this->childStrategy->unsetInterrupt();
+    }
+}
+
+void MpiComm::handleReceivedClauses(const uint8_t *clsBuf, int size, int source,
+                                    bool useFilter, vector<ClauseExchange *> *accepted)
+{
+    if (source < 0)
     {
-        if (clsBuf[i])
+        PackedClauseReader reader(clsBuf, size);
+        importClauses(reader, source, 0, useFilter, accepted);
+        if (reader.corrupted())
         {
-            tmp.push_back(clsBuf[i]);
+            log(0, "Rank %d read corrupted clauses in its node\n", rank);
         }
-        else
+    }
+    else
+    {
+        const uint8_t *message;
+        int length;
+        double start = getAbsoluteTime();
+        if (!MessageCodec::unpack(clsBuf, size, unpackBuf, message, length))
         {
-            int size = tmp.size();
-            if (!externalFilter.registerClause(tmp.data(), size))
+            log(0, "Rank %d received a corrupted clause message\n", rank);
+            return;
+        }
+        if (message != clsBuf + 1)
+            stats.codecTime += getAbsoluteTime() - start;
+
+        PackedClauseReader reader(message, length);
+        if (reader.readFeedback(feedback))
+        {
+            for (auto &fb : feedback)
             {
-                tmp.clear();
-                continue;
+                if (fb.rank == rank && fb.budget > 0)
+                    exportLimits[source] = {fb.budget, fb.lbdLimit};
             }
-            ClauseExchange *cls = ClauseManager::allocClause(size);
-            cls->size = size;
-            cls->from = -1; // from external
-            std::copy(tmp.begin(), tmp.end(), cls->lits);
-            clausesToImport.addClause(cls);
-            tmp.clear();
+        }
+
+        int hop;
+        while (reader.nextSection(hop))
+        {
+            importClauses(reader, source, hop, useFilter, accepted);
+        }
+
+        if (reader.corrupted())
+        {
+            log(0, "Rank %d received a corrupted clause message\n", rank);
         }
     }
 }
 
-void MpiComm::updateWorkingStatus()
+void MpiComm::importClauses(PackedClauseReader &reader, int source, int hop, bool useFilter,
+                            vector<ClauseExchange *> *accepted)
+{
+    // The accepted clauses are decoded first, then put in a single slab
+    decodedLits.clear();
+    decodedClauses.clear();
+    int lbd;
+    while (reader.next(clauseLits, lbd))
+    {
+        stats.clausesReceived++;
+        if (source >= 0)
+            peerStats[source].received++;
+        int size = clauseLits.size();
+        // Clauses from the leader are still registered so that they are
+        // not exported again
+        if (!externalFilter.registerClause(clauseLits.data(), size) && useFilter)
+        {
+            continue;
+        }
+        if (source >= 0)
+            peerStats[source].accepted++;
+        decodedClauses.push_back(make_pair(size, lbd));
+        decodedLits.insert(decodedLits.end(), clauseLits.begin(), clauseLits.end());
+    }
+
+    if (decodedClauses.empty())
+        return;
+
+    // Clauses that can travel further are forwarded at the next rounds, the
+    // hop comes from the wire
+    bool forward = hop >= 0 && hop < (int)forwardClauses.size();
+
+    ClauseSlab *slab = ClauseManager::allocSlab(decodedClauses.size(), decodedLits.size());
+    const int *pos = decodedLits.data();
+    for (auto &decoded : decodedClauses)
+    {
+        ClauseExchange *cls = ClauseManager::allocClause(slab, decoded.first);
+        cls->lbd = decoded.second;
+        cls->from = source >= 0 ? remoteOrigin(source) : -1;
+        std::copy(pos, pos + decoded.first, cls->lits);
+        pos += decoded.first;
+        if (accepted)
+        {
+            ClauseManager::increaseClause(cls, 1);
+            accepted->push_back(cls);
+        }
+        if (forward)
+        {
+            ClauseManager::increaseClause(cls, 1);
+            forwardClauses[hop].addClause(cls);
+        }
+        clausesToImport.addClause(cls);
+    }
+    ClauseManager::releaseSlab(slab);
+}
+
+PeerStatistics MpiComm::getPeerStatistics(int peer)
+{
+    PeerStatistics peerStat = peerStats[peer];
+    peerStat.used = peerUsed[peer];
+    return peerStat;
+}
+
+void MpiComm::reportClauseUsage(int from, int count)
+{
+    int peer = originRank(from);
+    if (peer >= 0 && peer < size)
+        peerUsed[peer] += count;
+}
+
+void MpiComm::discardMessage(MPI_Status &s)
 {
-    assert(rank == 0);
+    // clause messages are packed bytes, the other ones are integers
+    MPI_Datatype type = s.MPI_TAG == CLAUSE_TAG ? MPI_UNSIGNED_CHAR : MPI_INT;
+    int length;
+    MPI_Get_count(&s, type, &length);
+    vector<uint8_t> garbage(length * (type == MPI_INT ? sizeof(int) : 1));
+    MPI_Recv(garbage.data(), length, type, s.MPI_SOURCE, s.MPI_TAG, MPI_COMM_WORLD, &s);
+}
 
-    // Bcast stop message
-    log(1, "Root broadcasts result %d to the all ranks\n", res);
-    MPI_Request requests[size - 1];
-    for (int i = 1; i < size; i++)
+void MpiComm::updateWorkingStatus()
+{
+    // The root stops the ranks itself if no rank did, on a timeout, and
+    // makes sure that every rank stops in any case
+    if (rank == 0 && !stopStarted)
     {
-        MPI_Isend(&res, 1, MPI_INT, i, STOP_TAG, MPI_COMM_WORLD, &requests[i - 1]);
+        SatResult result = res.load();
+        log(1, "Root broadcasts result %d to the all ranks\n", (int)result);
+        stopStarted = true;
+        stopped = true;
+        sendStop(result, 0);
     }
-    MPI_Waitall(size - 1, requests, MPI_STATUSES_IGNORE);
+
+    // Sends complete at cleanReceivingBuffer
+    flushOutbox();
 }
 
 void MpiComm::reportResult(SatResult currRes, const vector<int> &model)
 {
-    if (res)
-        return;
+    // Only the first worker to finish reports
     assert(currRes != UNKNOWN);
-    res = currRes;
-    // Report the result to rank 0
-    int length = model.size();
-    // FIXME: free the buffer
-    int*  modelBuf = (int *) malloc(sizeof(int) * (length + 1));
-    std::copy(model.begin(), model.end(), modelBuf + 1);
+    SatResult expected = UNKNOWN;
+    if (!res.compare_exchange_strong(expected, currRes))
+        return;
+    // Report the result to rank 0: [result] [... model ...]
+    vector<int> modelBuf(model.size() + 1);
+    std::copy(model.begin(), model.end(), modelBuf.begin() + 1);
     modelBuf[0] = currRes;
     log(1, "Rank %d is the winner, reports result % d to the root\n ", rank, currRes);
-    MPI_Send(modelBuf, length + 1, MPI_INT, 0, REPORT_TAG, MPI_COMM_WORLD);
-    free(modelBuf);
+    postSend(modelBuf.data(), modelBuf.size(), 0, REPORT_TAG);
+
+    // The winner stops the other ranks while the model travels to the root
+    stopStarted = true;
+    stopped = true;
+    sendStop(currRes, rank);
+    if (rank != 0)
+        globalEnding = true;
 }
 
 void MpiComm::sendAssumption(const vector<int> &assumption, int targetRank)
 {
     // cube buffer: [cube length] [... cube ...]
-    int length = assumption.size();
-    // FIXME: no free here
-    int* buf = (int*) malloc(sizeof(int) * (length + 1));
-    std::copy(assumption.begin(), assumption.end(), buf + 1);
-    buf[0] = length;
-    // FIXME
-    MPI_Request req;
-    MPI_Ibsend(&buf, length + 1, MPI_INT, targetRank, CUBE_TAG, MPI_COMM_WORLD, &req);
+    vector<int> buf(assumption.size() + 1);
+    std::copy(assumption.begin(), assumption.end(), buf.begin() + 1);
+    buf[0] = assumption.size();
+    postSend(buf.data(), buf.size(), targetRank, CUBE_TAG);
 }
 
 void MpiComm::sendInterrupt(int interrupt, int targetRank)
 {
     // 0 for unset interrupt, 1 for interrupt
-    // FIXME
-    static int val;
-    val = interrupt;
-    MPI_Request req;
-    MPI_Isend(&val, 1, MPI_INT, targetRank, INTERRUPT_TAG, MPI_COMM_WORLD, &req);
-}
\ No newline at end of file
+    postSend(&interrupt, 1, targetRank, INTERRUPT_TAG);
+}
+
+void MpiComm::sendStealRequest(int victim)
+{
+    postSend(&victim, 1, victim, STEAL_TAG);
+}
+
+void MpiComm::sendNoCube(int thief)
+{
+    int none = -1;
+    postSend(&none, 1, thief, CUBE_TAG);
+}
+
+void MpiComm::sendClosedCube(const vector<int> &cube)
+{
+    // [cube length] [... cube ...]
+    vector<int> buf(cube.size() + 1);
+    std::copy(cube.begin(), cube.end(), buf.begin() + 1);
+    buf[0] = cube.size();
+    postSend(buf.data(), buf.size(), 0, CLOSED_TAG);
+}
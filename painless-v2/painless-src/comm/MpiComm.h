@@ -17,18 +17,83 @@
 // this program.  If not, see <http://www.gnu.org/licenses/>.
 // -----------------------------------------------------------------------------
 
+#pragma once
+
 #include <thread>
 #include <memory>
+#include <mutex>
+#include <condition_variable>
 #include <mpi.h>
 
 #include "../clauses/ClauseBuffer.h"
 #include "../clauses/ClauseFilter.h"
 #include "../clauses/ClauseDatabase.h"
+#include "../clauses/FastLane.h"
+#include "../comm/ClauseCodec.h"
+#include "../comm/MessageCodec.h"
 #include "../utils/SatUtils.h"
 #include "../working/WorkingStrategy.h"
 
 extern atomic<bool> globalEnding;
 
+class DistributedDivideAndConquer;
+
+/// Statistics of the inter-process clause sharing.
+struct CommStatistics
+{
+    CommStatistics()
+    {
+        rounds = 0;
+        messagesSent = 0;
+        clausesSent = 0;
+        bytesSent = 0;
+        fixedFormatBytes = 0;
+        clausesReceived = 0;
+        bytesReceived = 0;
+        nodeBytes = 0;
+        messagesDropped = 0;
+        codecBytesSaved = 0;
+        codecTime = 0;
+        filterFill = 0;
+        filterRotations = 0;
+        filterDuplicates = 0;
+        laneSent = 0;
+        laneReceived = 0;
+    }
+
+    unsigned long rounds;           ///< Number of rounds that exported clauses.
+    unsigned long messagesSent;     ///< Number of clause messages sent.
+    unsigned long clausesSent;      ///< Number of clauses sent to a peer.
+    unsigned long bytesSent;        ///< Number of bytes put on the wire.
+    unsigned long fixedFormatBytes; ///< Bytes the fixed-size format would use.
+    unsigned long clausesReceived;  ///< Number of clauses received.
+    unsigned long bytesReceived;    ///< Number of bytes received.
+    unsigned long nodeBytes;        ///< Bytes exchanged through shared memory.
+    unsigned long messagesDropped;  ///< Clause messages not sent to a slow peer.
+    unsigned long codecBytesSaved;  ///< Bytes saved by the compression.
+    double codecTime;               ///< Seconds spent to (de)compress.
+    double filterFill;              ///< Bits set in the filter generation.
+    unsigned long filterRotations;  ///< Filter generations retired.
+    unsigned long filterDuplicates; ///< Clauses rejected by the filter.
+    unsigned long laneSent;         ///< Units and binaries sent, fast lane.
+    unsigned long laneReceived;     ///< Units and binaries received, fast lane.
+};
+
+/// Statistics of the clauses received from one rank.
+struct PeerStatistics
+{
+    PeerStatistics()
+    {
+        received = 0;
+        accepted = 0;
+        used = 0;
+    }
+
+    unsigned long received; ///< Number of clauses received.
+    unsigned long accepted; ///< Number of clauses that passed the filter.
+    unsigned long used;     ///< Number of uses reported by the solvers.
+};
+
 // Communicator for inter-process communication
 // TODO: optimize the class design
 class MpiComm
@@ -42,24 +107,148 @@ public:
     void addClausesToExternal(const vector<ClauseExchange *> &clauses);
     void getClausesFromExternal(vector<ClauseExchange *> &clauses);
     void exportLearnedClauses();
+    void finishClauseExchange();
 
-    SatResult receiveIncomingMsg();
+    /// Handle the pending messages, return true if there was any.
+    bool receiveIncomingMsg();
     void cleanReceivingBuffer();
+
+    /// Stop the other ranks if needed once this rank stopped.
     void updateWorkingStatus();
+
+    /// Barrier that keeps forwarding the stop messages.
+    void barrier();
+
+    /// Wait until there is something to send or until the timeout.
+    void waitForWork(int usec);
     void reportResult(SatResult currRes, const vector<int> &model);
 
     void registerParentWorkingStrategy(WorkingStrategy *strategy) { this->parentStrategy.push_back(strategy); }
     void registerChildWorkingStrategy(WorkingStrategy *strategy) { this->childStrategy = strategy; }
+    void registerStealingStrategy(DistributedDivideAndConquer *strategy) { this->stealingStrategy = strategy; }
 
     void sendAssumption(const vector<int> &assumption, int targetRank);
     void sendInterrupt(int interrupt, int targetRank);
 
+    // Work stealing of the distributed divide and conquer, the cubes are
+    // sent with sendAssumption
+    void sendStealRequest(int victim);
+    void sendNoCube(int thief);
+    void sendClosedCube(const vector<int> &cube);
+
+    CommStatistics getStatistics()
+    {
+        stats.filterFill = externalFilter.fillRatio();
+        stats.filterRotations = externalFilter.getRotations();
+        stats.filterDuplicates = externalFilter.getDuplicates();
+        return stats;
+    }
+    PeerStatistics getPeerStatistics(int peer);
+
+    /// Count the uses of a clause imported from another rank, from is the
+    /// origin set at import.
+    void reportClauseUsage(int from, int count = 1);
+
+    /// Origin of the clauses imported from a rank, see ClauseExchange::from.
+    static int remoteOrigin(int rank) { return -rank - 2; }
+    static int originRank(int from) { return from <= -2 ? -from - 2 : -1; }
+
 private:
     MpiComm();
-    void handleReceivedClauses(int *clsBuf, int bufSize);
+    // Import the clauses of a packed buffer, the accepted ones are appended
+    // to accepted if not null. Buffers from a source rank start with its
+    // feedback, the ones of the node slots (source -1) do not.
+    void handleReceivedClauses(const uint8_t *clsBuf, int bufSize, int source,
+                               bool useFilter = true,
+                               vector<ClauseExchange *> *accepted = NULL);
+
+    // Sharing rate control
+    struct PeerLimits
+    {
+        int budget;
+        int lbdLimit;
+    };
+
+    // Select clauses to export and pack them in buf, return the number of clauses
+    int selectBatch(vector<uint8_t> &buf);
+
+    // Exchange engines, selected by shr-comm
+    void exchangePointToPoint();
+    void exchangeCollective();
+    void postGroupStep();
+    void exchangeHierarchical();
+
+    // Send sections of clauses to the peers of the sharing group, within
+    // their limits, the clauses of section i travelled i hops
+    void sendToGroup(vector<vector<ClauseExchange *>> &sections);
+    int encodeSections(vector<vector<ClauseExchange *>> &sections, const PeerLimits &limits,
+                       vector<uint8_t> &buf);
+
+    // Apply the compression stage to a clause message
+    void packMessage(const vector<uint8_t> &message, vector<uint8_t> &packed);
+
+    // Decode the clauses of a section and import the accepted ones
+    void importClauses(PackedClauseReader &reader, int source, int hop, bool useFilter,
+                       vector<ClauseExchange *> *accepted);
+
+    // Neighbours of this rank in the gossip topologies
+    void initGossip();
+    void pickRandomPeers();
+
+    PeerLimits groupLimits(const vector<int> &peers);
+    void updateImportLimits(int peer);
+    void appendFeedback(const vector<int> &peers, vector<uint8_t> &buf);
+    int encodeWithin(vector<ClauseExchange *> &batch, const PeerLimits &limits, vector<uint8_t> &buf);
+    int selectGroupBatch(vector<uint8_t> &buf);
+
+    // Shared memory slots of the ranks of the node, see exchangeHierarchical
+    void initNodeSharing();
+    void writeSlot(const vector<uint8_t> &buf);
+    bool readSlot(int nodePeer, vector<uint8_t> &buf);
+    void discardMessage(MPI_Status &s);
+
+    // A send owned by the communicator until its completion, the buffer may
+    // be shared by the sends of a message to several peers
+    struct PendingSend
+    {
+        shared_ptr<vector<uint8_t>> data;
+        MPI_Datatype type;
+        int count;
+        int dest;
+        int tag;
+    };
+
+    // Queue a message of integers, it is sent by the comm thread
+    void postSend(const int *vals, int count, int dest, int tag);
+
+    // Start the queued sends and reap the completed ones, called by the
+    // comm thread only
+    bool flushOutbox();
+    void startSend(const PendingSend &send);
+    void reapSends();
+
+    // Receive and drop the pending messages
+    void discardIncoming();
+
+    // Receive the units and binaries of the other ranks, and send them the
+    // local ones published in the fast lane since the last call
+    bool exchangeFastLane();
+
+    // Receive the probed fast lane message and publish its clauses
+    void handleUnits(MPI_Status &s);
+
+    // Handlers of the fixed-size control messages
+    bool pollControl();
+    void handleStop(int ret, int root);
+    void handleInterrupt(int ret, int source);
+
+    // Send the stop to the children of this rank in the tree rooted at root
+    void sendStop(int ret, int root);
+
+    void waitWithProgress(MPI_Request &req);
 
     ClauseFilter externalFilter;
-    ClauseBuffer clausesToImport;
+    ClauseBuffer clausesToImport{OVERFLOW_DROP_HIGHEST_LBD};
 
     // Shorter clauses can be export at the first time
     ClauseDatabase clausesToExport;
@@ -71,14 +260,152 @@ private:
     int clsShrLowerRank = -1;
     int clsShrUpperRank = -1;
 
-    int *importBuf;
-    int *exportBuf;
+    // ranks the clause messages are sent to
+    vector<int> clausePeers;
+
+    // packed clauses, see ClauseCodec
+    vector<uint8_t> importBuf;
+    vector<uint8_t> exportBuf;
+
+    // decoded clauses of a message, as (size, lbd) and their literals
+    vector<pair<int, int>> decodedClauses;
+    vector<int> decodedLits;
+    vector<int> clauseLits;
     int clauseBufLimit;
+    int litPerRound;
+
+    // Limits asked by the peers, and asked to them
+    vector<PeerLimits> exportLimits;
+    vector<PeerLimits> importLimits;
+
+    // Statistics per source rank, in total and at the last limits update
+    vector<PeerStatistics> peerStats;
+    vector<PeerStatistics> peerWindow;
+    unique_ptr<atomic<unsigned long>[]> peerUsed;
+
+    vector<ExportFeedback> feedback;
+    vector<ClauseExchange *> selected;
+    vector<uint8_t> sectionBuf;
+
+    // Compression of the clause messages, see MessageCodec
+    int shrCodec = CODEC_RAW;
+    int codecMinBytes = 256;
+    vector<uint8_t> messageBuf;
+    vector<uint8_t> unpackBuf;
+
+    CommStatistics stats;
+
+    // Positions in the logs of the fast lane of the next local clauses to
+    // send, and set when a solver published one
+    size_t laneSent[2] = {0, 0};
+    atomic<bool> laneWork{false};
+
+    // 0 for point-to-point messages, 1 for collective operations
+    int shrComm = 0;
+
+    // Collective exchange within the sharing group
+    enum GroupPhase
+    {
+        GROUP_IDLE,
+        GROUP_SIZES,
+        GROUP_DATA
+    };
+
+    MPI_Comm groupComm = MPI_COMM_NULL;
+    MPI_Comm groupCtrlComm = MPI_COMM_NULL;
+    int groupRank = 0;
+    int groupSize = 1;
+    MPI_Request groupReq = MPI_REQUEST_NULL;
+    GroupPhase groupPhase = GROUP_IDLE;
+    long groupSteps = 0;
+    int exportSize = 0;
+    vector<int> groupCounts;
+    vector<int> groupDispls;
+    vector<uint8_t> gatherBuf;
+
+    // batch of the next round, selected while the current one is in flight
+    vector<uint8_t> nextBatch;
+    int nextBatchSize = 0;
+    bool nextBatchReady = false;
+
+    // Sharing topologies, see shr-topo
+    enum SharingTopology
+    {
+        TOPO_FLAT,
+        TOPO_NODE_LEADERS,
+        TOPO_RING,
+        TOPO_HYPERCUBE,
+        TOPO_RANDOM
+    };
+
+    int shrTopo = TOPO_FLAT;
+
+    // Remote clauses are forwarded until they travelled ttl hops, the ones
+    // to forward with i + 1 hops are in forwardClauses[i]
+    int ttl = 1;
+    vector<ClauseDatabase> forwardClauses;
+
+    // Ranks of the sharing group, the random topology picks its peers in it
+    vector<int> groupMembers;
+    int fanout = 2;
+
+    // Header of the shared memory slot of a rank, a seqlock protects the
+    // data, the sequence number is odd while the owner writes.
+    struct NodeSlot
+    {
+        atomic<unsigned long> seq;
+        int length;
+        uint8_t data[0];
+    };
+
+    MPI_Comm nodeComm = MPI_COMM_NULL;
+    MPI_Comm leaderComm = MPI_COMM_NULL;
+    MPI_Win nodeWin = MPI_WIN_NULL;
+    int nodeRank = 0;
+    int nodeSize = 1;
+    vector<NodeSlot *> nodeSlots;
+    vector<int> slotCapacity;
+    vector<unsigned long> lastSeq;
+
+
+    // remote clauses accepted by a leader, to fan out to its node
+    vector<ClauseExchange *> remoteAccepted;
+    vector<uint8_t> slotBuf;
+
+    // Persistent receives of the fixed-size control messages
+    enum ControlRecv
+    {
+        STOP_RECV,
+        INTERRUPT_RECV,
+        NB_CONTROL_RECVS
+    };
+
+    MPI_Request controlReqs[NB_CONTROL_RECVS];
+    int controlVals[NB_CONTROL_RECVS][2];
+
+    // This rank started a stop, or was stopped
+    atomic<bool> stopStarted;
+    atomic<bool> stopped;
+
+    // Every rank reached cleanReceivingBuffer, stops are not forwarded anymore
+    bool allStopped;
+
+    // Sends queued by the other threads
+    vector<PendingSend> outbox;
+    mutex outboxLock;
+    condition_variable outboxCond;
+
+    // Sends in flight, and the number of clause messages in flight per peer
+    vector<PendingSend> inflight;
+    vector<MPI_Request> inflightReqs;
+    vector<int> clauseInflight;
 
     vector<int> model;
 
-    SatResult res = UNKNOWN;
+    // Claimed once, by a worker of this rank or by the comm thread
+    atomic<SatResult> res{UNKNOWN};
 
     vector<WorkingStrategy *> parentStrategy;
     WorkingStrategy *childStrategy = nullptr;
+    DistributedDivideAndConquer *stealingStrategy = nullptr;
 };
\ No newline at end of file
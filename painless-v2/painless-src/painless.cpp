@@ -20,6 +20,7 @@
 #include "painless.h"
 
 #include "clauses/ClauseManager.h"
+#include "clauses/FastLane.h"
 #include "sharing/HordeSatSharing.h"
 #include "sharing/Sharer.h"
 #include "sharing/SimpleSharing.h"
@@ -30,6 +31,7 @@
 #include "utils/SatUtils.h"
 #include "utils/System.h"
 #include "working/CubeAndConquer.h"
+#include "working/DistributedDivideAndConquer.h"
 #include "working/DivideAndConquer.h"
 #include "working/Portfolio.h"
 #include "working/Dispatcher.h"
@@ -78,31 +80,78 @@ int main(int argc, char ** argv)
              " 3=random, 4=native, 5=1&4, 6=sparse-random, 7=6&4," \
              " default is 0.\n");
       printf("\t-c=<INT>\t\t number of cpus, default is 4.\n");
-      printf("\t-wkr-strat=1...6\t 1=portfolio, 2=cube and conquer," \
-             " 4=divide and conquer, 6=distributed portfolio, default is portfolio\n");
+      printf("\t-wkr-strat=1...7\t 1=portfolio, 2=cube and conquer," \
+             " 4=divide and conquer, 6=distributed portfolio, 7=distributed" \
+             " divide and conquer with work stealing, default is portfolio\n");
       printf("\t-shr-strat=1...5\t 1=alltoall, 2=hordesat sharing," \
              " 5=distributed hordesat sharing, default is 0\n");
       printf("\t-shr-group=<INT>\t number of processes current process" \
              " will share clauses to, default is 0 (share to all)\n");
+      printf("\t-shr-comm=0...1\t\t inter-process clause exchange," \
+             " 0=point-to-point messages, 1=non-blocking collectives" \
+             " within each sharing group, default is 0\n");
+      printf("\t-shr-topo=0...4\t\t inter-process sharing topology," \
+             " 0=flat, 1=one leader per node exchanging with the other" \
+             " leaders, the ranks of a node use shared memory and shr-group" \
+             " counts leaders, 2=ring, 3=hypercube, 4=random neighbours," \
+             " default is 0\n");
+      printf("\t-shr-ttl=<INT>\t\t for shr-topo 2...4: hops a clause travels," \
+             " default depends on the topology and the group size\n");
+      printf("\t-shr-fanout=<INT>\t for shr-topo 4: neighbours picked each" \
+             " round, default is 2\n");
+      printf("\t-shr-codec=0...2\t compression of the inter-process clause" \
+             " messages, 0=none, 1=in-tree LZ, 2=zlib, default is 0\n");
+      printf("\t-shr-codec-min=<INT>\t smallest message in bytes that is" \
+             " compressed, default is 256\n");
+      printf("\t-shr-filter=0...1\t filter of the clauses already shared," \
+             " 0=Bloom, 1=exact fingerprints, default is 0\n");
       printf("\t-shr-sleep=<INT>\t time in usecond a sharer sleep each" \
              " round, default 500000 (0.5s)\n");
+      printf("\t-shr-push\t\t the solvers wake up their sharer for short" \
+             " clauses and when %d clauses wait\n", SHARING_WATERMARK);
+      printf("\t-shr-min-sleep=<INT>\t for shr-push: minimum time in usecond" \
+             " between two rounds, default 2000\n");
+      printf("\t-fast-lane\t\t units and binary clauses are shared at once" \
+             " with all the solvers and ranks\n");
+      printf("\t-comm-sleep=<INT>\t time in usecond between two inter-process" \
+             " clause exchanges, default 1000000 (1s)\n");
       printf("\t-shr-lit=<INT>\t\t number of literals shared per round by the" \
              " hordesat strategy, default is 1500\n");
+      printf("\t-simp-once\t\t for wkr-strat 1: the formula is simplified" \
+             " once before the glucose and maple solvers are cloned\n");
+      printf("\t-rebalance=<INT>\t for wkr-strat 1: every <INT> seconds, the" \
+             " weakest solver, if its conflicts per second over the average" \
+             " LBD are under half of the best one of the same type, is" \
+             " replaced by a rediversified clone of it, or rediversified if" \
+             " it cannot be cloned, lingeling is never rebalanced, default" \
+             " is 0 (never)\n");
       printf("\t-no-model\t\t won't print the model if the problem is SAT\n");
       printf("\t-t=<INT>\t\t timeout in second, default is no limit\n");
       printf("\t-split-heur=1...3\t for D&C: splitting heuristic," \
-             " 1=VSIDS, 2=flips, 3=propagation rate, default is 1\n");
+             " 1=activity, 2=flips, 3=propagation rate, default is 1\n");
       printf("\t-copy-mode=1...2\t for D&C: copy mode for solvers when " \
             "splitting work, 1=reuse the old solver, 2=clone solver and " \
             "delete old solver, default is 1\n");
+      printf("\t-cube-mode=1...2\t for wkr-strat 2: 1=a solver is cloned" \
+             " per division, 2=the cubes are made by lookahead and solved" \
+             " under assumptions by one solver per cpu, default is 1\n");
+      printf("\t-cube-count=<INT>\t for cube-mode 2: number of cubes," \
+             " default is 32 per cpu\n");
 
       return 0;
    }
 
    int mpiSize, mpiRank;
-   MPI_Init(&argc, &argv);
+   // Only one thread at a time uses MPI: the main thread before and after
+   // the solving, the comm thread in between
+   int provided;
+   MPI_Init_thread(&argc, &argv, MPI_THREAD_SERIALIZED, &provided);
    MPI_Comm_size(MPI_COMM_WORLD, &mpiSize);
    MPI_Comm_rank(MPI_COMM_WORLD, &mpiRank);
+
+   if (Parameters::isSet("fast-lane"))
+      FastLane::getInstance()->enable();
+
    MpiComm::getInstance()->init(mpiRank, mpiSize);
 
    if (mpiRank == 0) {
@@ -111,15 +160,14 @@ int main(int argc, char ** argv)
 
    setVerbosityLevel(Parameters::getIntParam("v", 0));
 
+   if (provided < MPI_THREAD_SERIALIZED) {
+      log(0, "Rank %d: MPI does not support serialized threads\n", mpiRank);
+   }
+
    int cpus = Parameters::getIntParam("c", 4);
 
    srand(time(NULL));
 
-   // Buffer for sent MPI messages
-   int bufSize = sizeof(int) * 100 * 1000 * 1000;
-   int* mpiBuf = (int*) malloc(bufSize);
-   MPI_Buffer_attach(mpiBuf, bufSize);
-
    // Create solvers
    vector<SolverInterface *> solvers;
    
@@ -127,7 +175,8 @@ int main(int argc, char ** argv)
    const int wkrStrat = Parameters::getIntParam("wkr-strat", 1);
 
    int nSolvers = cpus;
-   if (wkrStrat == 2 || wkrStrat == 5 || (wkrStrat == 4 &&
+   if ((wkrStrat == 2 && Parameters::getIntParam("cube-mode", 1) == 1) ||
+       wkrStrat == 5 || (wkrStrat == 4 &&
        Parameters::getIntParam("copy-mode", 1) == 2)) {
        nSolvers = 1;
    } else if (Parameters::getIntParam("wkr-strat", 1) == 3) {
@@ -244,7 +293,7 @@ int main(int argc, char ** argv)
    // Working strategy creation
    switch(Parameters::getIntParam("wkr-strat", 1)) {
       case 1 :
-         working = new Portfolio();
+         working = new Portfolio(Parameters::getIntParam("rebalance", 0));
          for (size_t i = 0; i < cpus; i++) {
             working->addSlave(new SequentialWorker(solvers[i]));
          }
@@ -252,7 +301,9 @@ int main(int argc, char ** argv)
 
       case 2 :
          working = new CubeAndConquer(cpus);
-         working->addSlave(new SequentialWorker(solvers[0]));
+         for (size_t i = 0; i < nSolvers; i++) {
+            working->addSlave(new SequentialWorker(solvers[i]));
+         }
          break;
 
       case 3 :
@@ -299,6 +350,13 @@ int main(int argc, char ** argv)
          }
          break;
 
+      case 7:
+         working = new DistributedDivideAndConquer(mpiRank, mpiSize);
+         for (size_t i = 0; i < cpus; i++) {
+            working->addSlave(new SequentialWorker(solvers[i]));
+         }
+         break;
+
       case 0 :
          break;
    }
@@ -308,15 +366,50 @@ int main(int argc, char ** argv)
 
    // Start a thread for the communicator
    std::thread commThread([&] {
+      // The messages are polled more often while there is traffic, the
+      // clauses are exchanged at their own pace
+      double clausePeriod = Parameters::getIntParam("comm-sleep", 1000000) / 1000000.0;
+      double lastExchange = getRelativeTime();
+      int wait = 1000;
+
       while (globalEnding == false) {
-         sleep(1);
-         
+         MpiComm::getInstance()->waitForWork(wait);
+
          // Handle incoming MPI messages
-         MpiComm::getInstance()->receiveIncomingMsg();
-         
+         bool activity = MpiComm::getInstance()->receiveIncomingMsg();
+         wait = activity ? 1000 : min(wait * 2, 10000);
+
          // Inter-process clause sharing
-         if (globalEnding == false)
+         if (globalEnding == false && getRelativeTime() - lastExchange >= clausePeriod) {
             MpiComm::getInstance()->exportLearnedClauses();
+            lastExchange = getRelativeTime();
+         }
+      }
+
+      // Make sure that all peers stop
+      MpiComm::getInstance()->updateWorkingStatus();
+
+      // Complete the pending collective exchanges
+      MpiComm::getInstance()->finishClauseExchange();
+
+      CommStatistics stats = MpiComm::getInstance()->getStatistics();
+      log(1, "Rank %d: sent %lu cls in %lu msgs, %lu bytes (%lu with fixed-size" \
+          " msgs), received %lu cls in %lu bytes, %lu bytes in node memory," \
+          " %lu msgs dropped, compression saved %lu bytes in %f s, filter" \
+          " %.2f%% full after %lu rotations, %lu duplicates, fast lane sent" \
+          " %lu received %lu\n", mpiRank,
+          stats.clausesSent, stats.messagesSent, stats.bytesSent,
+          stats.fixedFormatBytes, stats.clausesReceived, stats.bytesReceived,
+          stats.nodeBytes, stats.messagesDropped, stats.codecBytesSaved,
+          stats.codecTime, stats.filterFill * 100, stats.filterRotations,
+          stats.filterDuplicates, stats.laneSent, stats.laneReceived);
+
+      for (int i = 0; i < mpiSize; i++) {
+         PeerStatistics peerStats = MpiComm::getInstance()->getPeerStatistics(i);
+         if (peerStats.received == 0)
+            continue;
+         log(2, "Rank %d: from rank %d received %lu cls, %lu accepted, %lu used\n",
+             mpiRank, i, peerStats.received, peerStats.accepted, peerStats.used);
       }
    });
 
@@ -331,7 +424,7 @@ int main(int argc, char ** argv)
    int maxMemory = Parameters::getIntParam("max-memory", -1) * 1024 * 1024;
 
    while(globalEnding == false) {
-      sleep(1);
+      usleep(10000);
 
       if (maxMemory > 0 && getMemoryUsed() > maxMemory) {
          cout << "c Memory used is going too large!!!!" << endl;
@@ -343,10 +436,7 @@ int main(int argc, char ** argv)
       }   
    }
 
-   // Broadcast the result to all peers
-   if (mpiRank == 0) {
-      MpiComm::getInstance()->updateWorkingStatus();
-   }
+   commThread.join();
 
    // Get the consumed time
    double consumedTime = getRelativeTime();
@@ -370,7 +460,7 @@ int main(int argc, char ** argv)
       printf("t consumed time: %f\n", consumedTime);
    }
 
-   MPI_Barrier(MPI_COMM_WORLD);
+   MpiComm::getInstance()->barrier();
 
    // Delete sharers
    for (int i=0; i < nSharers; i++) {
@@ -382,9 +472,14 @@ int main(int argc, char ** argv)
    delete working;
 
    // Delete shared clauses
+   if (FastLane::getInstance()->isEnabled()) {
+      log(1, "Rank %d: fast lane %lu units, %lu binaries, %lu duplicates\n",
+          mpiRank, FastLane::getInstance()->size(true),
+          FastLane::getInstance()->size(false),
+          FastLane::getInstance()->getDuplicates());
+      FastLane::getInstance()->clear();
+   }
    ClauseManager::joinClauseManager();
-
-   commThread.join();
    
    // Clean MPI buffer and finalize MPI
    MpiComm::getInstance()->cleanReceivingBuffer();
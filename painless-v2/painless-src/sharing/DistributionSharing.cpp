@@ -29,7 +29,8 @@
 
 std::once_flag filterFlag;
 
-DistributionSharing::DistributionSharing()
+DistributionSharing::DistributionSharing() :
+   localFilter(FilterMode(Parameters::getIntParam("shr-filter", FILTER_BLOOM)))
 {
    literalPerRound = Parameters::getIntParam("shr-lit", 1500);
 }
@@ -46,13 +47,23 @@ void DistributionSharing::doSharing(int idSharer, const vector<SolverInterface *
    assert(from.size() == to.size());
    int nSolvers = to.size();
    std::call_once(filterFlag, [this, nSolvers] {
+      FilterMode mode = FilterMode(Parameters::getIntParam("shr-filter",
+                                                           FILTER_BLOOM));
       for (int i = 0; i < nSolvers; i++)
       {
-         this->solverFilters.push_back(new ClauseFilter());
+         this->solverFilters.push_back(new ClauseFilter(mode));
       }
    });
    assert(solverFilters.size() == nSolvers);
 
+   // The uses of the remote clauses drive the limits asked to the peers
+   measureUsefulness(to);
+   for (auto & usage : roundUsage)
+   {
+      if (usage.first <= -2 && usage.second.useful)
+         MpiComm::getInstance()->reportClauseUsage(usage.first, usage.second.useful);
+   }
+
    // Get learned clauses from solvers
    for (int i = 0; i < nSolvers; i++)
    {
@@ -64,13 +75,20 @@ void DistributionSharing::doSharing(int idSharer, const vector<SolverInterface *
 
       for (size_t k = 0; k < tmp.size(); k++)
       {
-         if (solverFilters[i]->registerClause(tmp[k]->lits, tmp[k]->size) && localFilter.registerClause(tmp[k]->lits, tmp[k]->size))
+         if (!solverFilters[i]->registerClause(tmp[k]->lits, tmp[k]->size))
+         {
+            stats.duplicateClauses++;
+            ClauseManager::releaseClause(tmp[k]);
+         }
+         else if (localFilter.registerClause(tmp[k]->lits, tmp[k]->size))
          {
             database.addClause(tmp[k]);
          }
          else
          {
-            ClauseManager::releaseClause(tmp[k]);
+            // Learnt by another solver too, worth more if not shared yet
+            stats.duplicateClauses++;
+            database.addSource(tmp[k]);
          }
       }
    }
@@ -80,6 +98,13 @@ void DistributionSharing::doSharing(int idSharer, const vector<SolverInterface *
    database.giveSelection(tmp, literalPerRound, &selectCount);
    stats.sharedClauses += selectCount;
 
+   // The selection mixes the producers, their quotas follow the usefulness
+   // of their own clauses only
+   for (int i = 0; i < nSolvers; i++)
+   {
+      adjustProductionToUsefulness(from[i]);
+   }
+
    // Add clauses to communicator clauseDB where clauses will be export
    MpiComm::getInstance()->addClausesToExternal(tmp);
 
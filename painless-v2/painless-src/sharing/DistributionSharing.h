@@ -52,9 +52,6 @@ protected:
    vector<ClauseFilter* > solverFilters;
    ClauseFilter localFilter;
 
-   /// Sharing statistics.
-   SharingStatistics stats;
-
    /// Used to manipulate clauses.
    vector<ClauseExchange *> tmp;
 };
@@ -36,6 +36,9 @@ void
 HordeSatSharing::doSharing(int idSharer, const vector<SolverInterface *> & from,
                            const vector<SolverInterface *> & to)
 {
+   attachConsumers(to);
+   measureUsefulness(to);
+
    for (size_t i = 0; i < from.size(); i++) {
       int used, usedPercent, selectCount;
       
@@ -56,10 +59,10 @@ HordeSatSharing::doSharing(int idSharer, const vector<SolverInterface *> & from,
 
       stats.sharedClauses += selectCount;
 
-      if (usedPercent < 80) {
-         from[i]->increaseClauseProduction();
-         log(1, "Sharer %d production increase for solver %d.\n", idSharer,
-             from[i]->id);
+      int usefulPercent = adjustProduction(from[i], usedPercent >= 80);
+      if (usefulPercent >= 0) {
+         log(1, "Sharer %d: %d%% of the clauses of solver %d were useful\n",
+             idSharer, usefulPercent, from[i]->id);
       }
 
       if (selectCount > 0) {
@@ -68,18 +71,7 @@ HordeSatSharing::doSharing(int idSharer, const vector<SolverInterface *> & from,
       }
 
 
-      for (int j = 0; j < to.size(); j++) {
-         if (from[i]->id != to[j]->id) {
-            for (size_t k = 0; k < tmp.size(); k++) {
-               ClauseManager::increaseClause(tmp[k], 1);
-            }
-            to[j]->addLearnedClauses(tmp);
-         }
-      }
-
-      for (size_t k = 0; k < tmp.size(); k++) {
-         ClauseManager::releaseClause(tmp[k]);
-      }
+      broadcast(from[i]->id, tmp, to);
    }
 }
 
@@ -49,9 +49,6 @@ protected:
    /// Databse used to store the clauses.
    ClauseDatabase database;
 
-   /// Sharing statistics.
-   SharingStatistics stats;
-
    /// Used to manipulate clauses.
    vector<ClauseExchange *> tmp;   
 };
@@ -35,10 +35,22 @@ static void * mainThrSharing(void * arg)
    Sharer * shr  = (Sharer *)arg;
    int round     = 0;
    int sleepTime = Parameters::getIntParam("shr-sleep", 500000);
+   int minSleep  = Parameters::getIntParam("shr-min-sleep", 2000);
+   double lastRound = getAbsoluteTime();
 
    while (true) {
       // Sleep 
-      usleep(sleepTime);
+      if (shr->event) {
+         // Woken up by the producers, but not more often than minSleep
+         shr->event->wait(sleepTime);
+
+         int elapsed = (getAbsoluteTime() - lastRound) * 1000000;
+         if (elapsed < minSleep)
+            usleep(minSleep - elapsed);
+         lastRound = getAbsoluteTime();
+      } else {
+         usleep(sleepTime);
+      }
    
       if (globalEnding)
          break; // Need to stop
@@ -46,8 +58,9 @@ static void * mainThrSharing(void * arg)
       round++; // New round
 
       SharingStatistics stats = shr->sharingStrategy->getStatistics();
-      log(2, "Sharer %d enter in round  %d, received cls %ld, shared cls %ld\n",
-          shr->id, round, stats.receivedClauses, stats.sharedClauses);
+      log(2, "Sharer %d enter in round  %d, received cls %ld, shared cls %ld," \
+          " duplicate cls %ld\n", shr->id, round, stats.receivedClauses,
+          stats.sharedClauses, stats.duplicateClauses);
 
 
       // Add new solvers
@@ -62,6 +75,33 @@ static void * mainThrSharing(void * arg)
                             shr->addConsumers.end());
       shr->addConsumers.clear();
 
+      // A replacing solver takes the places of the replaced one, if any
+      for (size_t i = 0; i < shr->replaceSolvers.size(); i++) {
+         SolverInterface * oldSolver = shr->replaceSolvers[i].first;
+         SolverInterface * newSolver = shr->replaceSolvers[i].second;
+
+         for (auto & solver : shr->producers) {
+            if (solver == oldSolver) {
+               solver = newSolver;
+               newSolver->increase();
+               if (shr->event)
+                  newSolver->setSharingEvent(shr->event);
+               oldSolver->release();
+            }
+         }
+
+         for (auto & solver : shr->consumers) {
+            if (solver == oldSolver) {
+               solver = newSolver;
+               newSolver->increase();
+               oldSolver->release();
+            }
+         }
+
+         newSolver->release();
+      }
+      shr->replaceSolvers.clear();
+
       shr->addLock.unlock();
 
 
@@ -100,8 +140,10 @@ static void * mainThrSharing(void * arg)
 
    SharingStatistics stats = shr->sharingStrategy->getStatistics();
 
-   log(1,"Sharer %d: received cls %ld, shared cls %ld\n", shr->id,
-         stats.receivedClauses, stats.sharedClauses);
+   log(1,"Sharer %d: received cls %ld, shared cls %ld, duplicate cls %ld," \
+         " imported cls %ld, useful cls %ld\n", shr->id,
+         stats.receivedClauses, stats.sharedClauses, stats.duplicateClauses,
+         stats.importedClauses, stats.usefulClauses);
 
    return NULL;
 }
@@ -115,8 +157,13 @@ Sharer::Sharer(int id, SharingStrategy * sharingStrategy,
    this->producers       = producers;
    this->consumers       = consumers;
 
+   if (Parameters::isSet("shr-push"))
+      event = make_shared<SharingEvent>();
+
    for (size_t i = 0; i < producers.size(); i++) {
       producers[i]->increase();
+      if (event)
+         producers[i]->setSharingEvent(event);
    }
 
    for (size_t i = 0; i < consumers.size(); i++) {
@@ -131,6 +178,13 @@ Sharer::~Sharer()
    sharer->join();
    delete sharer;
 
+   // The producers may outlive the sharer
+   if (event) {
+      for (auto solver : producers) {
+         solver->setSharingEvent(NULL);
+      }
+   }
+
    removeLock.lock();
 
    for (int i = 0; i < removeProducers.size(); i++) {
@@ -143,6 +197,10 @@ Sharer::~Sharer()
 
    removeLock.unlock();
 
+   for (size_t i = 0; i < replaceSolvers.size(); i++) {
+      replaceSolvers[i].second->release();
+   }
+
    delete sharingStrategy;
 }
 
@@ -150,6 +208,8 @@ void
 Sharer::addProducer(SolverInterface * solver)
 {
    solver->increase();
+   if (event)
+      solver->setSharingEvent(event);
 
    addLock.lock();
    addProducers.push_back(solver);
@@ -166,6 +226,17 @@ Sharer::addConsumer(SolverInterface * solver)
    addLock.unlock();
 }
 
+void
+Sharer::replaceSolver(SolverInterface * oldSolver, SolverInterface * newSolver)
+{
+   // Held until the replacement is done
+   newSolver->increase();
+
+   addLock.lock();
+   replaceSolvers.push_back(make_pair(oldSolver, newSolver));
+   addLock.unlock();
+}
+
 void
 Sharer::removeProducer(SolverInterface * solver)
 {
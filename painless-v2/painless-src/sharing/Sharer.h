@@ -19,6 +19,7 @@
 
 #pragma once
 
+#include "../sharing/SharingEvent.h"
 #include "../sharing/SharingStrategy.h"
 #include "../utils/Threading.h"
 
@@ -44,6 +45,10 @@ public:
    /// Add a solver to the consumers.
    void addConsumer(SolverInterface * solver);
 
+   /// Replace a solver by another one, in the producers and the consumers
+   /// where it is.
+   void replaceSolver(SolverInterface * oldSolver, SolverInterface * newSolver);
+
    /// Remove a solver from the producers.
    void removeProducer(SolverInterface * solver);
 
@@ -71,6 +76,9 @@ protected:
    /// Vector of solvers to add to the consumers.
    vector<SolverInterface *> addConsumers;
 
+   /// Solvers to replace, with the solver replacing them.
+   vector<pair<SolverInterface *, SolverInterface *> > replaceSolvers;
+
    /// Vector of solvers to remove from the producers.
    vector<SolverInterface *> removeProducers;
    
@@ -85,4 +93,7 @@ protected:
    
    /// Pointer to the thread in chrage of sharing.
    Thread * sharer;
+
+   /// Event set by the producers in push mode, NULL otherwise.
+   shared_ptr<SharingEvent> event;
 };
@@ -0,0 +1,73 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2021
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+using namespace std;
+
+/// Clauses waiting in a producer that wake up its sharer.
+#define SHARING_WATERMARK 256
+
+/// Clauses of this size or shorter wake up the sharer at once.
+#define SHARING_SHORT_CLAUSE 2
+
+/// Event used by the producers to wake up their sharer.
+class SharingEvent
+{
+public:
+   /// Constructor.
+   SharingEvent()
+   {
+      pending = false;
+   }
+
+   /// Wake up the sharer, only the first notification takes the lock.
+   void notify()
+   {
+      if (pending.exchange(true))
+         return;
+
+      lock_guard<mutex> guard(lock);
+      cond.notify_one();
+   }
+
+   /// Wait for a notification at most usec microseconds.
+   /// @return true if notified.
+   bool wait(int usec)
+   {
+      unique_lock<mutex> guard(lock);
+
+      if (!pending)
+         cond.wait_for(guard, chrono::microseconds(usec));
+
+      return pending.exchange(false);
+   }
+
+protected:
+   atomic<bool> pending;
+
+   mutex lock;
+
+   condition_variable cond;
+};
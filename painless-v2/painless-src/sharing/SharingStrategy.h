@@ -21,18 +21,35 @@
 
 #include "../solvers/SolverInterface.h"
 
+#include <map>
+#include <unordered_map>
 #include <vector>
 
 using namespace std;
 
+/// Number of imports of the clauses of a producer after which its production
+/// is adjusted to their usefulness.
+#define SHARING_USEFUL_WINDOW 500
+
+/// Percentage of the imported clauses of a producer used in a conflict
+/// analysis under which the producer exports less.
+#define SHARING_USEFUL_LOW 10
+
+/// Percentage over which the producer exports more, when the usefulness alone
+/// drives its production.
+#define SHARING_USEFUL_HIGH 30
+
 /// Sharing statistics.
 struct SharingStatistics
 {
    /// Constructor.
    SharingStatistics()
    {
-      sharedClauses   = 0;
-      receivedClauses = 0;
+      sharedClauses    = 0;
+      receivedClauses  = 0;
+      duplicateClauses = 0;
+      importedClauses  = 0;
+      usefulClauses    = 0;
    }
 
    /// Number of shared clauses that have been shared.
@@ -40,6 +57,15 @@ struct SharingStatistics
 
    /// Number of shared clauses produced.
    unsigned long receivedClauses;
+
+   /// Number of clauses rejected as already seen.
+   unsigned long duplicateClauses;
+
+   /// Number of clauses of the producers imported by the consumers.
+   unsigned long importedClauses;
+
+   /// Number of them used in a conflict analysis.
+   unsigned long usefulClauses;
 };
 
 /// Strategy to shared clauses.
@@ -56,4 +82,128 @@ public:
 
    /// Return the sharing statistics of this sharng strategy.
    virtual SharingStatistics getStatistics() = 0;
+
+protected:
+   /// Make the new consumers read the channel of this strategy.
+   void attachConsumers(const vector<SolverInterface *> & consumers)
+   {
+      if (!channel)
+         channel = make_shared<ClauseChannel>();
+
+      for (auto solver : consumers) {
+         if (!solver->readsChannel(channel.get()))
+            solver->attachChannel(channel);
+      }
+   }
+
+   /// Give the clauses of a producer to the consumers, the reference of
+   /// each clause goes to the channel.
+   void broadcast(int producerId, const vector<ClauseExchange *> & clauses,
+                  const vector<SolverInterface *> & consumers)
+   {
+      // Consumers that could not attach the channel get their own copies
+      for (auto solver : consumers) {
+         if (solver->id == producerId || solver->readsChannel(channel.get()))
+            continue;
+
+         for (auto cls : clauses) {
+            ClauseManager::increaseClause(cls, 1);
+         }
+         solver->addLearnedClauses(clauses);
+      }
+
+      channel->publish(clauses);
+   }
+
+   /// Collect the clauses imported and used by the consumers since the last
+   /// call, by origin, in roundUsage, and add them to the windows.
+   void measureUsefulness(const vector<SolverInterface *> & consumers)
+   {
+      roundUsage.clear();
+
+      for (auto solver : consumers) {
+         usage.clear();
+         solver->getImportUsage(usage);
+
+         for (auto & total : usage) {
+            ImportUsage & last = lastUsage[make_pair(solver->id, total.from)];
+            ImportUsage & round = roundUsage[total.from];
+            ImportUsage & window = usefulness[total.from];
+
+            unsigned long imported = total.imported - last.imported;
+            unsigned long useful   = total.useful - last.useful;
+
+            round.from      = total.from;
+            round.imported += imported;
+            round.useful   += useful;
+            window.imported += imported;
+            window.useful   += useful;
+
+            last = total;
+         }
+      }
+   }
+
+   /// Close the usefulness window of a producer once it is full.
+   /// @return the percentage of its clauses used, -1 if the window is open.
+   int closeWindow(SolverInterface * producer)
+   {
+      ImportUsage & window = usefulness[producer->id];
+
+      if (window.imported < SHARING_USEFUL_WINDOW)
+         return -1;
+
+      int percent = 100 * window.useful / window.imported;
+
+      stats.importedClauses += window.imported;
+      stats.usefulClauses   += window.useful;
+      window.imported = window.useful = 0;
+
+      return percent;
+   }
+
+   /// Adjust the production of a producer to the usefulness of its clauses
+   /// over the last window, the fill of its buffer decides otherwise.
+   /// @return the percentage of its clauses used, -1 if not decided on it.
+   int adjustProduction(SolverInterface * producer, bool bufferFilled)
+   {
+      int percent = closeWindow(producer);
+
+      if (percent >= 0 && percent < SHARING_USEFUL_LOW) {
+         producer->decreaseClauseProduction();
+      } else if (bufferFilled == false) {
+         producer->increaseClauseProduction();
+      }
+
+      return percent;
+   }
+
+   /// Adjust the production of a producer to the usefulness of its clauses
+   /// only, once per window.
+   /// @return the percentage of its clauses used, -1 if not decided on it.
+   int adjustProductionToUsefulness(SolverInterface * producer)
+   {
+      int percent = closeWindow(producer);
+
+      if (percent >= 0 && percent < SHARING_USEFUL_LOW) {
+         producer->decreaseClauseProduction();
+      } else if (percent > SHARING_USEFUL_HIGH) {
+         producer->increaseClauseProduction();
+      }
+
+      return percent;
+   }
+
+   /// Broadcast of the shared clauses, the consumers skip their own ones.
+   shared_ptr<ClauseChannel> channel;
+
+   /// Sharing statistics.
+   SharingStatistics stats;
+
+   /// Clauses imported and used, by consumer and origin at the last measure,
+   /// by origin during the last measure and the current windows.
+   map<pair<int, int>, ImportUsage> lastUsage;
+   unordered_map<int, ImportUsage> roundUsage;
+   unordered_map<int, ImportUsage> usefulness;
+   vector<ImportUsage> usage;
 };
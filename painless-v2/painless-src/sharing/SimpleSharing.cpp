@@ -28,6 +28,8 @@ void
 SimpleSharing::doSharing(int idSharer, const vector<SolverInterface *> & from,
                          const vector<SolverInterface *> & to)
 {
+   attachConsumers(to);
+
    for (int i = 0; i < from.size(); i++) {
       tmp.clear();
 
@@ -36,18 +38,7 @@ SimpleSharing::doSharing(int idSharer, const vector<SolverInterface *> & from,
       stats.receivedClauses += tmp.size();
       stats.sharedClauses   += tmp.size();
 
-      for (size_t j = 0; j < to.size(); j++) {
-         if (from[i]->id != to[j]->id) {
-            for (size_t k = 0; k < tmp.size(); k++) {
-               ClauseManager::increaseClause(tmp[k], 1);
-            }
-            to[j]->addLearnedClauses(tmp);
-         }
-      }
-            
-      for (size_t k = 0; k < tmp.size(); k++) {
-         ClauseManager::releaseClause(tmp[k]);
-      }
+      broadcast(from[i]->id, tmp, to);
    }
 }
 
@@ -38,7 +38,4 @@ public:
 protected:
    /// Used to manipulate clauses.
    vector<ClauseExchange *> tmp;
-   
-   /// Sharing statistics.
-   SharingStatistics stats;
 };
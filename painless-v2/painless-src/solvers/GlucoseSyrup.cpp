@@ -52,7 +52,7 @@ void glucoseExportUnary(void * issuer, Lit & l)
    ncls->lbd     = 1;
    ncls->lits[0] = INT_LIT(l);
 
-   gs->clausesToExport.addClause(ncls); 
+   gs->exportClause(gs->clausesToExport, ncls);
 }
 
 void glucoseExportClause(void * issuer, Clause & cls)
@@ -71,7 +71,7 @@ void glucoseExportClause(void * issuer, Clause & cls)
       ncls->lits[i] = INT_LIT(cls[i]);
    }
 
-   gs->clausesToExport.addClause(ncls); 
+   gs->exportClause(gs->clausesToExport, ncls);
 }
 
 Lit glucoseImportUnary(void * issuer)
@@ -82,12 +82,12 @@ Lit glucoseImportUnary(void * issuer)
 
    ClauseExchange * cls = NULL;
 
-   if (gs->unitsToImport.getClause(&cls) == false)
+   if (gs->importClause(gs->unitsToImport, true, &cls) == false)
       return l;
 
    l = GLUE_LIT(cls->lits[0]);
 
-   ClauseManager::releaseClause(cls);
+   gs->doneImport(cls, true);
 
    return l;
 }
@@ -98,18 +98,26 @@ bool glucoseImportClause(void * issuer, int * from, vec<Lit> & gcls)
 
    ClauseExchange * cls = NULL;
 
-   if (gs->clausesToImport.getClause(&cls) == false)
+   if (gs->importClause(gs->clausesToImport, false, &cls) == false)
       return false;
 
    makeGlueVec(cls, gcls);
 
-   *from = cls->from;
+   *from = gs->originTag(cls->from);
+   gs->clauseImported(*from);
 
-   ClauseManager::releaseClause(cls);
+   gs->doneImport(cls, false);
 
    return true;
 }
 
+void glucoseImportedClauseUsed(void * issuer, int from)
+{
+   GlucoseSyrup * gs = (GlucoseSyrup*)issuer;
+
+   gs->importedClauseUsed(from);
+}
+
 GlucoseSyrup::GlucoseSyrup(int id) : SolverInterface(id, GLUCOSE)
 {
    glueLimit = Parameters::getIntParam("lbd-limit", 100);
@@ -130,6 +138,7 @@ GlucoseSyrup::GlucoseSyrup(int id) : SolverInterface(id, GLUCOSE)
    solver->exportClause = glucoseExportClause;
    solver->importUnary  = glucoseImportUnary;
    solver->importClause = glucoseImportClause;
+   solver->importedClauseUsed = glucoseImportedClauseUsed;
    solver->issuer       = this;
 }
 
@@ -154,6 +163,7 @@ GlucoseSyrup::GlucoseSyrup(const GlucoseSyrup & other, int id) :
    solver->exportClause = glucoseExportClause;
    solver->importUnary  = glucoseImportUnary;
    solver->importClause = glucoseImportClause;
+   solver->importedClauseUsed = glucoseImportedClauseUsed;
    solver->issuer       = this;
 }
 
@@ -235,6 +245,13 @@ GlucoseSyrup::setSolverInterrupt()
    solver->interrupt();
 }
 
+// Simplify the formula before cloning the solver
+void
+GlucoseSyrup::simplifyFormula()
+{
+   solver->eliminate(true);
+}
+
 // Diversify the solver
 void
 GlucoseSyrup::diversify(int id)
@@ -436,7 +453,8 @@ GlucoseSyrup::increaseClauseProduction()
 void
 GlucoseSyrup::decreaseClauseProduction()
 {
-   glueLimit--;
+   if (glueLimit > 2)
+      glueLimit--;
 }
 
 SolvingStatistics
@@ -449,6 +467,8 @@ GlucoseSyrup::getStatistics()
    stats.restarts     = solver->starts;
    stats.decisions    = solver->decisions;
    stats.memPeak      = memUsedPeak();
+   stats.lbdSum       = solver->sumLBD;
+   getImportStatistics(stats);
 
    return stats;
 }
@@ -95,6 +95,9 @@ public:
    /// Native diversification.
    void diversify(int id);
 
+   /// Run the variable elimination once.
+   void simplifyFormula();
+
    void getHeuristicData(vector<int> ** flipActivity,
                          vector<int> ** nbPropagations,
                          vector<int> ** nbDecisionVar);
@@ -120,10 +123,10 @@ protected:
    ClauseBuffer unitsToImport;
 
    /// Buffer used to import clauses.
-   ClauseBuffer clausesToImport;
+   ClauseBuffer clausesToImport{OVERFLOW_DROP_HIGHEST_LBD};
 
    /// Buffer used to import clauses (units included).
-   ClauseBuffer clausesToExport;
+   ClauseBuffer clausesToExport{OVERFLOW_DROP_HIGHEST_LBD};
 
    /// Buffer used to add permanent clauses.
    ClauseBuffer clausesToAdd;
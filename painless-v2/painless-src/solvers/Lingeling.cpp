@@ -42,10 +42,11 @@ void produceUnit(void * sp, int lit)
    ClauseExchange * ncls = ClauseManager::allocClause(1);
 
    ncls->lits[0] = lit;
+   ncls->lbd     = 1;
    ncls->from    = lp->id;
 
    // Add it to the buffer for export
-   lp->clausesToExport.addClause(ncls);
+   lp->exportClause(lp->clausesToExport, ncls);
 }
 
 void produce(void * sp, int * cls, int glue)
@@ -76,36 +77,29 @@ void produce(void * sp, int * cls, int glue)
    ncls->from = lp->id;
 
    // Add it to the buffer for export
-   lp->clausesToExport.addClause(ncls);
+   lp->exportClause(lp->clausesToExport, ncls);
 }
 
 void consumeUnits(void * sp, int ** start, int ** end)
 {
    Lingeling* lp = (Lingeling*)sp;
    
-   vector<ClauseExchange *> tmp;
-
-   lp->unitsToImport.getClauses(tmp);
-
-	if (tmp.empty()) {
-		*start = lp->unitsBuffer;
-		*end   = lp->unitsBuffer;
-		return;
-	}
+   ClauseExchange * cls = NULL;
+   int nUnits = 0;
 
-	if (tmp.size() >= lp->unitsBufferSize) {
-		lp->unitsBufferSize = 1.6 * tmp.size();
-		lp->unitsBuffer     = (int *)realloc((void *)lp->unitsBuffer,
-                                           lp->unitsBufferSize * sizeof(int));
-	}
+   while (lp->importClause(lp->unitsToImport, true, &cls)) {
+      if (nUnits >= lp->unitsBufferSize) {
+         lp->unitsBufferSize = 1.6 * (nUnits + 1);
+         lp->unitsBuffer     = (int *)realloc((void *)lp->unitsBuffer,
+                                              lp->unitsBufferSize * sizeof(int));
+      }
 
-	for (size_t i = 0; i < tmp.size(); i++) {
-		lp->unitsBuffer[i] = tmp[i]->lits[0];
-      ClauseManager::releaseClause(tmp[i]);
-	}
+      lp->unitsBuffer[nUnits++] = cls->lits[0];
+      lp->doneImport(cls, true);
+   }
 
 	*start = lp->unitsBuffer;
-	*end   = *start + tmp.size();
+	*end   = *start + nUnits;
 }
 
 void consumeCls(void* sp, int ** clause, int * glue)
@@ -114,7 +108,7 @@ void consumeCls(void* sp, int ** clause, int * glue)
 
    ClauseExchange * cls = NULL;
    
-   if (lp->clausesToImport.getClause(&cls) == false) {
+   if (lp->importClause(lp->clausesToImport, false, &cls) == false) {
 		*clause = NULL;
 		return;
 	}
@@ -130,7 +124,7 @@ void consumeCls(void* sp, int ** clause, int * glue)
    memcpy(lp->clsBuffer, cls->lits, sizeof(int)*cls->size);
    lp->clsBuffer[cls->size] = 0;
 
-   ClauseManager::releaseClause(cls);
+   lp->doneImport(cls, false);
 
    *clause = lp->clsBuffer;
 }
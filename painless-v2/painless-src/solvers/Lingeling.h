@@ -117,10 +117,10 @@ protected:
    ClauseBuffer unitsToImport;
 
    /// Buffer used to import clauses.
-   ClauseBuffer clausesToImport;
+   ClauseBuffer clausesToImport{OVERFLOW_DROP_HIGHEST_LBD};
 
    /// Buffer used to export clauses (units included).
-   ClauseBuffer clausesToExport;
+   ClauseBuffer clausesToExport{OVERFLOW_DROP_HIGHEST_LBD};
 
    /// Size of the unit array used by Lingeling.
    size_t unitsBufferSize;
@@ -51,6 +51,8 @@ void cbkMapleCOMSPSExportClause(void *issuer, int lbd, vec<Lit> &cls)
 {
    Maple *mp = (Maple *)issuer;
 
+   mp->lbdSum += lbd;
+
    if (lbd > mp->lbdLimit)
       return;
 
@@ -64,7 +66,7 @@ void cbkMapleCOMSPSExportClause(void *issuer, int lbd, vec<Lit> &cls)
    ncls->lbd = lbd;
    ncls->from = mp->id;
 
-   mp->clausesToExport.addClause(ncls);
+   mp->exportClause(mp->clausesToExport, ncls);
 }
 
 Lit cbkMapleCOMSPSImportUnit(void *issuer)
@@ -75,55 +77,79 @@ Lit cbkMapleCOMSPSImportUnit(void *issuer)
 
    ClauseExchange *cls = NULL;
 
-   if (mp->unitsToImport.getClause(&cls) == false)
+   if (mp->importClause(mp->unitsToImport, true, &cls) == false)
       return l;
 
    l = MINI_LIT(cls->lits[0]);
 
-   ClauseManager::releaseClause(cls);
+   mp->doneImport(cls, true);
 
    return l;
 }
 
-bool cbkMapleCOMSPSImportClause(void *issuer, int *lbd, vec<Lit> &mcls)
+bool cbkMapleCOMSPSImportClause(void *issuer, int *lbd, int *origin,
+                                vec<Lit> &mcls)
 {
    Maple *mp = (Maple *)issuer;
 
    ClauseExchange *cls = NULL;
 
-   if (mp->clausesToImport.getClause(&cls) == false)
+   if (mp->importClause(mp->clausesToImport, false, &cls) == false)
       return false;
 
    makeMiniVec(cls, mcls);
 
-   *lbd = cls->lbd;
+   *lbd    = cls->lbd;
+   *origin = mp->originTag(cls->from);
+   mp->clauseImported(*origin);
 
-   ClauseManager::releaseClause(cls);
+   mp->doneImport(cls, false);
 
    return true;
 }
 
+void cbkMapleCOMSPSImportedClauseUsed(void *issuer, int origin)
+{
+   Maple *mp = (Maple *)issuer;
+
+   mp->importedClauseUsed(origin);
+}
+
 Maple::Maple(int id) : SolverInterface(id, MAPLE)
 {
    lbdLimit = Parameters::getIntParam("lbd-limit", 2);
+   lbdSum   = 0;
 
    solver = new SimpSolver();
 
+   switch (Parameters::getIntParam("split-heur", 1)) {
+      case 2:
+         solver->useFlip = true;
+         break;
+      case 3:
+         solver->usePR = true;
+         break;
+      default:;
+   }
+
    solver->cbkExportClause = cbkMapleCOMSPSExportClause;
    solver->cbkImportClause = cbkMapleCOMSPSImportClause;
    solver->cbkImportUnit = cbkMapleCOMSPSImportUnit;
+   solver->cbkImportedClauseUsed = cbkMapleCOMSPSImportedClauseUsed;
    solver->issuer = this;
 }
 
 Maple::Maple(const Maple &other, int id) : SolverInterface(id, MAPLE)
 {
    lbdLimit = Parameters::getIntParam("lbd-limit", 2);
+   lbdSum   = 0;
 
    solver = new SimpSolver(*(other.solver));
 
    solver->cbkExportClause = cbkMapleCOMSPSExportClause;
    solver->cbkImportClause = cbkMapleCOMSPSImportClause;
    solver->cbkImportUnit = cbkMapleCOMSPSImportUnit;
+   solver->cbkImportedClauseUsed = cbkMapleCOMSPSImportedClauseUsed;
    solver->issuer = this;
 }
 
@@ -152,7 +178,24 @@ int Maple::getVariablesCount()
 // Get a variable suitable for search splitting
 int Maple::getDivisionVariable()
 {
-   return (rand() % getVariablesCount()) + 1;
+   Lit res;
+
+   switch (Parameters::getIntParam("split-heur", 1)) {
+      case 2:
+         res = solver->pickBranchLitUsingFlipActivity();
+         break;
+      case 3:
+         res = solver->pickBranchLitUsingPropagationRate();
+         break;
+      default:
+         res = solver->pickBranchLitUsingActivity();
+   }
+
+   // No statistics yet, or every variable is assigned
+   if (res == lit_Undef)
+      return (rand() % getVariablesCount()) + 1;
+
+   return INT_LIT(res);
 }
 
 // Set initial phase for a given variable
@@ -181,6 +224,12 @@ void Maple::unsetSolverInterrupt()
    solver->clearInterrupt();
 }
 
+// Simplify the formula before cloning the solver
+void Maple::simplifyFormula()
+{
+   solver->eliminate(true);
+}
+
 // Diversify the solver
 void Maple::diversify(int id)
 {
@@ -241,7 +290,10 @@ Maple::solve(const vector<int> &cube)
    vec<Lit> miniAssumptions;
    for (size_t ind = 0; ind < cube.size(); ind++)
    {
-      miniAssumptions.push(MINI_LIT(cube[ind]));
+      // As in GlucoseSyrup, an eliminated variable is not assumed
+      Lit l = MINI_LIT(cube[ind]);
+      if (!solver->isEliminated(var(l)))
+         miniAssumptions.push(l);
    }
 
    lbool res = solver->solveLimited(miniAssumptions);
@@ -343,6 +395,8 @@ Maple::getStatistics()
    stats.restarts = solver->starts;
    stats.decisions = solver->decisions;
    stats.memPeak = memUsedPeak();
+   stats.lbdSum = lbdSum;
+   getImportStatistics(stats);
 
    return stats;
 }
@@ -388,4 +442,36 @@ Maple::getSatAssumptions()
       outCls.push_back(-(INT_LIT(lits[i])));
    }
    return outCls;
-};
\ No newline at end of file
+};
+
+void
+Maple::getHeuristicData(vector<int> ** flipActivity,
+                        vector<int> ** nbPropagations,
+                        vector<int> ** nbDecisionVar)
+{
+   if (flipActivity != NULL) {
+      *flipActivity = &(solver->flipActivity);
+   }
+   if (nbPropagations != NULL) {
+      *nbPropagations = &(solver->nbPropagations);
+   }
+   if (nbDecisionVar != NULL) {
+      *nbDecisionVar = &(solver->nbDecisionVar);
+   }
+}
+
+void
+Maple::setHeuristicData(vector<int> * flipActivity,
+                        vector<int> * nbPropagations,
+                        vector<int> * nbDecisionVar)
+{
+   if (flipActivity != NULL) {
+      solver->flipActivity = *flipActivity;
+   }
+   if (nbPropagations != NULL) {
+      solver->nbPropagations = *nbPropagations;
+   }
+   if (nbDecisionVar != NULL) {
+      solver->nbDecisionVar = *nbDecisionVar;
+   }
+}
@@ -95,6 +95,17 @@ public:
    /// Native diversification.
    void diversify(int id);
 
+   /// Run the variable elimination once.
+   void simplifyFormula();
+
+   void getHeuristicData(vector<int> ** flipActivity,
+                         vector<int> ** nbPropagations,
+                         vector<int> ** nbDecisionVar);
+
+   void setHeuristicData(vector<int> * flipActivity,
+                         vector<int> * nbPropagations,
+                         vector<int> * nbDecisionVar);
+
    /// Constructor.
    Maple(int id);
 
@@ -113,11 +124,11 @@ protected:
    MapleCOMSPS::SimpSolver *solver;
 
    /// Buffer used to import clauses (units included).
-   ClauseBuffer clausesToImport;
+   ClauseBuffer clausesToImport{OVERFLOW_DROP_HIGHEST_LBD};
    ClauseBuffer unitsToImport;
 
    /// Buffer used to export clauses (units included).
-   ClauseBuffer clausesToExport;
+   ClauseBuffer clausesToExport{OVERFLOW_DROP_HIGHEST_LBD};
 
    /// Buffer used to add permanent clauses.
    ClauseBuffer clausesToAdd;
@@ -125,11 +136,15 @@ protected:
    /// Size limit used to share clauses.
    atomic<int> lbdLimit;
 
+   /// Sum of the LBD of the learnt clauses.
+   unsigned long lbdSum;
+
    /// Used to stop or continue the resolution.
    atomic<bool> stopSolver;
 
    /// Callback to export/import clauses.
    friend MapleCOMSPS::Lit cbkMapleCOMSPSImportUnit(void *);
-   friend bool cbkMapleCOMSPSImportClause(void *, int *, MapleCOMSPS::vec<MapleCOMSPS::Lit> &);
+   friend bool cbkMapleCOMSPSImportClause(void *, int *, int *,
+                                          MapleCOMSPS::vec<MapleCOMSPS::Lit> &);
    friend void cbkMapleCOMSPSExportClause(void *, int, MapleCOMSPS::vec<MapleCOMSPS::Lit> &);
 };
\ No newline at end of file
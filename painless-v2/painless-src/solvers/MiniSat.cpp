@@ -47,6 +47,8 @@ void minisatExportClause(void * issuer, vec<Lit> & cls)
 {
 	MiniSat * ms = (MiniSat*)issuer;
 
+	ms->lbdSum += cls.size();
+
 	if (cls.size() > ms->sizeLimit)
 		return;
 
@@ -62,7 +64,7 @@ void minisatExportClause(void * issuer, vec<Lit> & cls)
 
    ncls->from = ms->id;
 
-   ms->clausesToExport.addClause(ncls);
+   ms->exportClause(ms->clausesToExport, ncls);
 }
 
 Lit minisatImportUnit(void * issuer)
@@ -73,12 +75,12 @@ Lit minisatImportUnit(void * issuer)
 
    ClauseExchange * cls = NULL;
 
-   if (ms->unitsToImport.getClause(&cls) == false)
+   if (ms->importClause(ms->unitsToImport, true, &cls) == false)
       return l;
 
    l = MINI_LIT(cls->lits[0]);
 
-   ClauseManager::releaseClause(cls);
+   ms->doneImport(cls, true);
 
    return l;
 }
@@ -89,12 +91,12 @@ bool minisatImportClause(void * issuer, vec<Lit> & mcls)
 
    ClauseExchange * cls = NULL;
 
-   if (ms->clausesToImport.getClause(&cls) == false)
+   if (ms->importClause(ms->clausesToImport, false, &cls) == false)
       return false;
 
    makeMiniVec(cls, mcls);
 
-   ClauseManager::releaseClause(cls);
+   ms->doneImport(cls, false);
 
    return true;
 }
@@ -102,10 +104,21 @@ bool minisatImportClause(void * issuer, vec<Lit> & mcls)
 MiniSat::MiniSat(int id) : SolverInterface(id, MINISAT)
 {
 	sizeLimit = Parameters::getIntParam("lbd-limit", 2);
+	lbdSum    = 0;
 
 	solver = new SimpSolver();
 	solver->remove_satisfied=false;
 
+	switch (Parameters::getIntParam("split-heur", 1)) {
+		case 2:
+			solver->useFlip = true;
+			break;
+		case 3:
+			solver->usePR = true;
+			break;
+		default:;
+	}
+
 	solver->exportClauseCallback = minisatExportClause;
 	solver->importUnitCallback   = minisatImportUnit;
 	solver->importClauseCallback = minisatImportClause;
@@ -140,7 +153,24 @@ MiniSat::getVariablesCount()
 int
 MiniSat::getDivisionVariable()
 {
-   return (rand() % getVariablesCount()) + 1;
+   Lit res;
+
+   switch (Parameters::getIntParam("split-heur", 1)) {
+      case 2:
+         res = solver->pickBranchLitUsingFlipActivity();
+         break;
+      case 3:
+         res = solver->pickBranchLitUsingPropagationRate();
+         break;
+      default:
+         res = solver->pickBranchLitUsingActivity();
+   }
+
+   // No statistics yet, or every variable is assigned
+   if (res == lit_Undef)
+      return (rand() % getVariablesCount()) + 1;
+
+   return INT_LIT(res);
 }
 
 // Set initial phase for a given variable
@@ -201,6 +231,10 @@ MiniSat::solve(const vector<int> & cube)
 
    vec<Lit> miniAssumptions;
    for (size_t ind = 0; ind < cube.size(); ind++) {
+      // As in GlucoseSyrup, an eliminated variable is not assumed
+      if (solver->isEliminated(abs(cube[ind]) - 1))
+         continue;
+
       miniAssumptions.push(MINI_LIT(cube[ind]));
    }
 
@@ -302,6 +336,7 @@ MiniSat::getStatistics()
    stats.restarts     = solver->starts;
    stats.decisions    = solver->decisions;
    stats.memPeak      = memUsedPeak();
+   stats.lbdSum       = lbdSum;
 
    return stats;
 }
@@ -320,3 +355,35 @@ MiniSat::getModel()
 
    return model;
 }
+
+void
+MiniSat::getHeuristicData(vector<int> ** flipActivity,
+                          vector<int> ** nbPropagations,
+                          vector<int> ** nbDecisionVar)
+{
+   if (flipActivity != NULL) {
+      *flipActivity = &(solver->flipActivity);
+   }
+   if (nbPropagations != NULL) {
+      *nbPropagations = &(solver->nbPropagations);
+   }
+   if (nbDecisionVar != NULL) {
+      *nbDecisionVar = &(solver->nbDecisionVar);
+   }
+}
+
+void
+MiniSat::setHeuristicData(vector<int> * flipActivity,
+                          vector<int> * nbPropagations,
+                          vector<int> * nbDecisionVar)
+{
+   if (flipActivity != NULL) {
+      solver->flipActivity = *flipActivity;
+   }
+   if (nbPropagations != NULL) {
+      solver->nbPropagations = *nbPropagations;
+   }
+   if (nbDecisionVar != NULL) {
+      solver->nbDecisionVar = *nbDecisionVar;
+   }
+}
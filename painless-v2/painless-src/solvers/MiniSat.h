@@ -94,6 +94,14 @@ public:
    /// Native diversification.
    void diversify(int id);
 
+   void getHeuristicData(vector<int> ** flipActivity,
+                         vector<int> ** nbPropagations,
+                         vector<int> ** nbDecisionVar);
+
+   void setHeuristicData(vector<int> * flipActivity,
+                         vector<int> * nbPropagations,
+                         vector<int> * nbDecisionVar);
+
    /// Constructor.
    MiniSat(int id);
    
@@ -108,16 +116,19 @@ protected:
    ClauseBuffer unitsToImport;
 
    /// Buffer used to import clauses.
-   ClauseBuffer clausesToImport;
+   ClauseBuffer clausesToImport{OVERFLOW_DROP_HIGHEST_LBD};
 
    /// Buffer used to export clauses (units included).
-   ClauseBuffer clausesToExport;
+   ClauseBuffer clausesToExport{OVERFLOW_DROP_HIGHEST_LBD};
 
    /// Buffer used to add permanent clauses.
    ClauseBuffer clausesToAdd;
    
    /// Size limit used to share clauses.
    atomic<int> sizeLimit;
+
+   /// Sum of the sizes of the learnt clauses, used as their LBD.
+   unsigned long lbdSum;
    
    /// Callback to export/import clauses.
    friend void minisatExportClause(void *, Minisat::vec<Minisat::Lit, int> &);
@@ -153,17 +153,7 @@ SolverFactory::createGlucoseSolvers(int nbSolvers, int mpiRank,
 
    solvers.push_back(createGlucoseSolver());
 
-   double memoryUsed    = getMemoryUsed();
-   int maxMemorySolvers = Parameters::getIntParam("max-memory", 51) * 1024 *
-                          1024 / memoryUsed;
-
-   if (nbSolvers > maxMemorySolvers) {
-      nbSolvers = maxMemorySolvers;
-   }
-
-   for (int i = 1; i < nbSolvers; i++) {
-      solvers.push_back(cloneSolver(solvers[0]));
-   }
+   cloneWithinMemory(nbSolvers, solvers);
 }
 
 void
@@ -198,17 +188,7 @@ SolverFactory::createMapleSolvers(int nbSolvers, int mpiRank,
    
    solvers.push_back(createMapleSolver());
 
-   double memoryUsed    = getMemoryUsed();
-   int maxMemorySolvers = Parameters::getIntParam("max-memory", 51) * 1024 *
-                          1024 / memoryUsed;
-
-   if (nbSolvers > maxMemorySolvers) {
-      nbSolvers = maxMemorySolvers;
-   }
-
-   for (int i = 1; i < nbSolvers; i++) {
-      solvers.push_back(cloneSolver(solvers[0]));
-   }
+   cloneWithinMemory(nbSolvers, solvers);
 }
 
 void
@@ -243,6 +223,47 @@ SolverFactory::createComboSolvers(int nbSolvers, int mpiRank,
    }
 }
 
+void
+SolverFactory::cloneWithinMemory(int nbSolvers,
+                                 vector<SolverInterface *> & solvers)
+{
+   double maxMemory = Parameters::getIntParam("max-memory", 51) * 1024. * 1024;
+
+   // The variable elimination is done once for all the solvers, and without
+   // the simplifier the clones only copy the remaining clauses. The cubes of
+   // the other strategies could contain eliminated variables
+   if (Parameters::isSet("simp-once") &&
+       Parameters::getIntParam("wkr-strat", 1) == 1) {
+      solvers[0]->simplifyFormula();
+   }
+
+   double memoryUsed    = getMemoryUsed();
+   int maxMemorySolvers = maxMemory / memoryUsed;
+
+   if (Parameters::isSet("simp-once") && nbSolvers > 1) {
+      // The limit is given by the memory of a clone, not of the process
+      double vm, before, after;
+      process_mem_usage(vm, before);
+      solvers.push_back(cloneSolver(solvers[0]));
+      process_mem_usage(vm, after);
+
+      double cloneMemory = max(after - before, 1.);
+      maxMemorySolvers   = 2 + (maxMemory - max(memoryUsed, after)) /
+                               cloneMemory;
+
+      log(1, "Solver clone uses %.0f Ko, process %.0f Ko\n", cloneMemory,
+          after);
+   }
+
+   if (nbSolvers > maxMemorySolvers) {
+      nbSolvers = maxMemorySolvers;
+   }
+
+   for (int i = solvers.size(); i < nbSolvers; i++) {
+      solvers.push_back(cloneSolver(solvers[0]));
+   }
+}
+
 SolverInterface *
 SolverFactory::cloneSolver(SolverInterface * other)
 {
@@ -268,6 +289,9 @@ SolverFactory::cloneSolver(SolverInterface * other)
          return NULL;
    }
 
+   // The copied clauses keep the origin tags of other
+   solver->copyOriginTags(*other);
+
    return solver;
 }
 
@@ -90,4 +90,10 @@ public:
 
    /// Apply a binary value diversification on solvers.
    static void binValueDiversification(const vector<SolverInterface *> &solvers);
+
+protected:
+   /// Clone the first solver of a group until the group has nbSolvers
+   /// solvers, or until the max-memory limit is reached.
+   static void cloneWithinMemory(int nbSolvers,
+                                 vector<SolverInterface *> &solvers);
 };
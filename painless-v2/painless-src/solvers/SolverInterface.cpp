@@ -0,0 +1,273 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2021
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#include "../clauses/FastLane.h"
+#include "../solvers/SolverInterface.h"
+
+//-------------------------------------------------
+// Constructor & Destructor
+//-------------------------------------------------
+SolverInterface::SolverInterface(int solverId, SolverType solverType)
+{
+   id    = solverId;
+   type  = solverType;
+   nRefs = 1;
+
+   nbChannels   = 0;
+   nextChannel  = 0;
+   importing[0] = importing[1] = NULL;
+
+   lanePos[0]    = lanePos[1]    = 0;
+   laneImport[0] = laneImport[1] = false;
+
+   nbOriginTags = 1;
+   for (int i = 0; i < MAX_ORIGIN_TAGS / ORIGIN_TAG_BLOCK; i++) {
+      tagBlocks[i] = NULL;
+   }
+}
+
+SolverInterface::~SolverInterface()
+{
+   for (int i = 0; i < nbChannels; i++) {
+      delete channels[i];
+   }
+
+   for (int i = 0; i < MAX_ORIGIN_TAGS / ORIGIN_TAG_BLOCK; i++) {
+      delete tagBlocks[i].load();
+   }
+}
+
+//-------------------------------------------------
+//  Channels and fast lane
+//-------------------------------------------------
+bool
+SolverInterface::attachChannel(const shared_ptr<ClauseChannel> & channel)
+{
+   int nb = nbChannels;
+   if (nb == MAX_SOLVER_CHANNELS)
+      return false;
+
+   ChannelReader * reader = new ChannelReader(channel, id);
+   if (reader->isAttached() == false) {
+      // The channel is full, the clauses are given as private copies
+      delete reader;
+      return false;
+   }
+
+   channels[nb] = reader;
+   nbChannels++;
+
+   return true;
+}
+
+void
+SolverInterface::setSharingEvent(const shared_ptr<SharingEvent> & event)
+{
+   atomic_store(&sharingEvent, event);
+}
+
+void
+SolverInterface::exportClause(ClauseBuffer & buffer, ClauseExchange * cls)
+{
+   int size = cls->size;
+
+   if (size <= 2 && FastLane::getInstance()->isEnabled() &&
+       FastLane::getInstance()->publish(cls))
+      return;
+
+   buffer.addClause(cls);
+
+   if (size > SHARING_SHORT_CLAUSE && buffer.size() < SHARING_WATERMARK)
+      return;
+
+   shared_ptr<SharingEvent> event = atomic_load(&sharingEvent);
+   if (event)
+      event->notify();
+}
+
+bool
+SolverInterface::readsChannel(const ClauseChannel * channel)
+{
+   for (int i = 0; i < nbChannels; i++) {
+      if (channels[i]->channel.get() == channel)
+         return true;
+   }
+
+   return false;
+}
+
+bool
+SolverInterface::importClause(ClauseBuffer & buffer, bool unit,
+                              ClauseExchange ** cls)
+{
+   if (importLane(unit, cls)) {
+      laneImport[unit] = true;
+      return true;
+   }
+
+   laneImport[unit] = false;
+
+   if (buffer.getClause(cls)) {
+      importing[unit] = NULL;
+      return true;
+   }
+
+   int nb = nbChannels;
+   for (int i = 0; i < nb; i++) {
+      ChannelReader * reader = channels[(nextChannel + i) % nb];
+      *cls = reader->next(unit);
+
+      if (*cls) {
+         importing[unit] = reader;
+         nextChannel     = (nextChannel + i + 1) % nb;
+         return true;
+      }
+   }
+
+   return false;
+}
+
+void
+SolverInterface::doneImport(ClauseExchange * cls, bool unit)
+{
+   if (laneImport[unit]) {
+      // Kept by the lane
+      laneImport[unit] = false;
+   } else if (importing[unit]) {
+      importing[unit]->done(unit);
+      importing[unit] = NULL;
+   } else {
+      ClauseManager::releaseClause(cls);
+   }
+}
+
+bool
+SolverInterface::importLane(bool unit, ClauseExchange ** cls)
+{
+   FastLane * lane = FastLane::getInstance();
+   if (lane->isEnabled() == false)
+      return false;
+
+   while ((*cls = lane->get(unit, lanePos[unit])) != NULL) {
+      lanePos[unit]++;
+
+      if ((*cls)->from != id)
+         return true;
+   }
+
+   return false;
+}
+
+//-------------------------------------------------
+//  Origins of the imported clauses
+//-------------------------------------------------
+OriginTagBlock *
+SolverInterface::tagBlock(int tag)
+{
+   atomic<OriginTagBlock *> & slot = tagBlocks[tag / ORIGIN_TAG_BLOCK];
+   OriginTagBlock * block = slot.load(memory_order_relaxed);
+
+   if (block == NULL) {
+      block = new OriginTagBlock;
+      for (int i = 0; i < ORIGIN_TAG_BLOCK; i++) {
+         block->origins[i]  = 0;
+         block->imported[i] = 0;
+         block->useful[i]   = 0;
+      }
+      slot.store(block, memory_order_release);
+   }
+
+   return block;
+}
+
+int
+SolverInterface::originTag(int from)
+{
+   auto it = originTags.find(from);
+   if (it != originTags.end())
+      return it->second;
+
+   int tag = nbOriginTags;
+   if (tag == MAX_ORIGIN_TAGS)
+      return 0;
+
+   // The first tag allocates the block of tag 0 too
+   tagBlock(tag)->origins[tag % ORIGIN_TAG_BLOCK] = from;
+   nbOriginTags.store(tag + 1, memory_order_release);
+   originTags[from] = tag;
+
+   return tag;
+}
+
+void
+SolverInterface::copyOriginTags(SolverInterface & other)
+{
+   originTags = other.originTags;
+
+   int nb = other.nbOriginTags;
+   for (int tag = 1; tag < nb; tag++) {
+      tagBlock(tag)->origins[tag % ORIGIN_TAG_BLOCK] =
+         other.tagBlocks[tag / ORIGIN_TAG_BLOCK].load()->
+         origins[tag % ORIGIN_TAG_BLOCK];
+   }
+   nbOriginTags.store(nb, memory_order_release);
+}
+
+void
+SolverInterface::clauseImported(int tag)
+{
+   tagBlocks[tag / ORIGIN_TAG_BLOCK].load(memory_order_relaxed)->
+      imported[tag % ORIGIN_TAG_BLOCK]++;
+}
+
+void
+SolverInterface::importedClauseUsed(int tag)
+{
+   tagBlocks[tag / ORIGIN_TAG_BLOCK].load(memory_order_relaxed)->
+      useful[tag % ORIGIN_TAG_BLOCK]++;
+}
+
+void
+SolverInterface::getImportStatistics(SolvingStatistics & stats)
+{
+   stats.imported = stats.useful = 0;
+
+   int nb = nbOriginTags.load(memory_order_acquire);
+   for (int tag = 0; tag < nb; tag++) {
+      OriginTagBlock * block = tagBlocks[tag / ORIGIN_TAG_BLOCK].load();
+      if (block == NULL)
+         continue;
+
+      stats.imported += block->imported[tag % ORIGIN_TAG_BLOCK];
+      stats.useful   += block->useful[tag % ORIGIN_TAG_BLOCK];
+   }
+}
+
+void
+SolverInterface::getImportUsage(vector<ImportUsage> & usage)
+{
+   int nb = nbOriginTags.load(memory_order_acquire);
+   for (int tag = 1; tag < nb; tag++) {
+      OriginTagBlock * block = tagBlocks[tag / ORIGIN_TAG_BLOCK].load();
+      int i = tag % ORIGIN_TAG_BLOCK;
+
+      usage.push_back({block->origins[i], block->imported[i],
+                       block->useful[i]});
+   }
+}
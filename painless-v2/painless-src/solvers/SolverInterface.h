@@ -19,12 +19,16 @@
 
 #pragma once
 
+#include "../clauses/ClauseBuffer.h"
+#include "../clauses/ClauseChannel.h"
 #include "../clauses/ClauseExchange.h"
+#include "../sharing/SharingEvent.h"
 #include "../utils/System.h"
 #include "../utils/Logger.h"
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <unordered_map>
 #include <vector>
 
 
@@ -61,6 +65,9 @@ struct SolvingStatistics
       conflicts    = 0;
       restarts     = 0;
       memPeak      = 0;
+      imported     = 0;
+      useful       = 0;
+      lbdSum       = 0;
    }
 
 	unsigned long propagations; ///< Number of propagations.
@@ -68,9 +75,43 @@ struct SolvingStatistics
 	unsigned long conflicts;    ///< Number of reached conflicts.
 	unsigned long restarts;     ///< Number of restarts.
 	double        memPeak;      ///< Maximum memory used in Ko.
+	unsigned long imported;     ///< Number of clauses imported.
+	unsigned long useful;       ///< Imported clauses used in a conflict.
+	double        lbdSum;       ///< Sum of the LBD of the learnt clauses, 0
+	                            ///< if the solver does not compute it.
 };
 
 
+/// Clauses imported from one origin, see ClauseExchange::from.
+struct ImportUsage
+{
+   int           from;     ///< Solver or remote rank of the clauses.
+   unsigned long imported; ///< Number of clauses imported.
+   unsigned long useful;   ///< Number of them used in a conflict analysis.
+};
+
+
+/// Maximum number of channels a solver imports from.
+#define MAX_SOLVER_CHANNELS 64
+
+/// Maximum number of origins whose clauses are tracked by a solver, the tag
+/// of an origin fits in 10 bits of a clause header.
+#define MAX_ORIGIN_TAGS 1024
+
+/// Number of tags whose counters are allocated together, on first use.
+#define ORIGIN_TAG_BLOCK 32
+
+/// Origins and counters of a block of tags.
+struct OriginTagBlock
+{
+   /// Origin of each tag.
+   int origins[ORIGIN_TAG_BLOCK];
+
+   /// Clauses imported and used for each tag.
+   atomic<unsigned long> imported[ORIGIN_TAG_BLOCK];
+   atomic<unsigned long> useful[ORIGIN_TAG_BLOCK];
+};
+
 /// Interface of a solver that provides standard features.
 class SolverInterface
 {
@@ -144,20 +185,61 @@ public:
    {
    }
 
+   /// Simplify the formula now and free the simplifier, so that the clones
+   /// copy the simplified clauses only.
+   virtual void simplifyFormula()
+   {
+   }
+
+   /// Import the clauses of a channel too, called by the sharer.
+   /// @return false if the solver reads too many channels, or the channel has
+   /// too many readers.
+   bool attachChannel(const shared_ptr<ClauseChannel> & channel);
+
+   /// Set the event waking up the sharer of this producer, NULL for none.
+   void setSharingEvent(const shared_ptr<SharingEvent> & event);
+
+   /// Put an exported clause in the buffer, and wake up the sharer when the
+   /// clause is short or when enough clauses are waiting. The units and the
+   /// binaries go through the fast lane when it is enabled.
+   void exportClause(ClauseBuffer & buffer, ClauseExchange * cls);
+
+   /// Return true if the solver imports the clauses of the channel.
+   bool readsChannel(const ClauseChannel * channel);
+
+   /// Get a unit or a clause to import, from the fast lane first, then from
+   /// the buffer, else from the channels. It is given back with doneImport.
+   bool importClause(ClauseBuffer & buffer, bool unit, ClauseExchange ** cls);
 
+   /// Give back a clause got from importClause.
+   void doneImport(ClauseExchange * cls, bool unit);
+
+   /// Tag kept by the solver in an imported clause, from the origin of the
+   /// clause. It is 0 for the clauses that are not tracked.
+   int originTag(int from);
+
+   /// Take the tags of other, whose clauses are copied by a clone with their
+   /// tags, called while other is not solving.
+   void copyOriginTags(SolverInterface & other);
+
+   /// Count a clause imported with tag, called by the solver thread.
+   void clauseImported(int tag);
+
+   /// First use in a conflict analysis of a clause imported with tag,
+   /// called by the solver thread.
+   void importedClauseUsed(int tag);
+
+   /// Set the numbers of clauses imported and used of the statistics.
+   void getImportStatistics(SolvingStatistics & stats);
+
+   /// Add the clauses imported and used since the start for each origin.
+   void getImportUsage(vector<ImportUsage> & usage);
 
    /// Constructor.
-   SolverInterface(int solverId, SolverType solverType)
-   {
-      id    = solverId;
-      type  = solverType;
-      nRefs = 1;
-   }
+   SolverInterface(int solverId, SolverType solverType);
 
    /// Destructor.
-   virtual ~SolverInterface()
-   {
-   }
+   virtual ~SolverInterface();
 
    /// Increase the counter of references of this solver.
    void increase()
@@ -188,4 +270,36 @@ public:
 
    /// Number of references pointing on this solver.
    atomic<int> nRefs;
+
+protected:
+   /// Get the next unit or binary of the fast lane not exported by this
+   /// solver.
+   bool importLane(bool unit, ClauseExchange ** cls);
+
+   /// Block of the counters of a tag, allocated by the solver thread.
+   OriginTagBlock * tagBlock(int tag);
+
+   /// Readers of the channels, added by the sharers.
+   ChannelReader * channels[MAX_SOLVER_CHANNELS];
+   atomic<int> nbChannels;
+
+   /// Event of the sharer in push mode.
+   shared_ptr<SharingEvent> sharingEvent;
+
+   /// Channel read by importClause, used by the solver thread only.
+   int nextChannel;
+   ChannelReader * importing[2];
+
+   /// Position of the solver in the logs of the fast lane, and whether the
+   /// clause being imported comes from it.
+   size_t lanePos[2];
+   bool laneImport[2];
+
+   /// Tags of the origins of the imported clauses, tag 0 is not tracked. The
+   /// map is used by the solver thread only.
+   unordered_map<int, int> originTags;
+   atomic<int> nbOriginTags;
+
+   /// Origins and counters of the tags, by block of ORIGIN_TAG_BLOCK tags.
+   atomic<OriginTagBlock *> tagBlocks[MAX_ORIGIN_TAGS / ORIGIN_TAG_BLOCK];
 };
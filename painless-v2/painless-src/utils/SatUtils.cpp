@@ -20,9 +20,11 @@
 #include "../clauses/ClauseManager.h"
 #include "../utils/SatUtils.h"
 
+#include <algorithm>
 #include <ctype.h>
 #include <math.h>
 #include <stdio.h>
+#include <zlib.h>
 
 static unsigned intWidth(int i)
 {
@@ -56,83 +58,136 @@ void printModel(vector<int> & model)
 }
 
 
-bool loadFormulaToSolvers(vector<SolverInterface*> solvers,
-                          const char* filename)
+/// Buffered reader of a possibly gzipped file, as the solvers read it.
+class FormulaReader
 {
-	FILE* f = fopen(filename, "r");
+public:
+   FormulaReader(gzFile in_) : in(in_), pos(0), size(0) {}
+
+   /// Return the next character of the file, or EOF.
+   int next()
+   {
+      if (pos >= size) {
+         size = gzread(in, buf, sizeof(buf));
+         pos  = 0;
+
+         if (size <= 0)
+            return EOF;
+      }
+
+      return (unsigned char) buf[pos++];
+   }
+
+protected:
+   gzFile in;
+
+   char buf[1 << 16];
+
+   int pos;
+
+   int size;
+};
+
+/// Parse the cnf contained in the file, calling onClause for each clause.
+template <typename F>
+static bool parseFormula(const char* filename, int & nbVars, F onClause)
+{
+   gzFile in = gzopen(filename, "rb");
+
+   if (in == NULL)
+      return false;
+
+   FormulaReader f(in);
 
-	if (f == NULL)
-		return false;
-	
-	int c    = 0;
-	bool neg = false;
+   int c    = 0;
+   bool neg = false;
 
-	vector<ClauseExchange *> clauses;
+   vector<int> cls;
 
-	vector<int> cls;
+   nbVars = 0;
 
-	while (c != EOF) {
-		c = fgetc(f);
+   while (c != EOF) {
+      c = f.next();
 
-		// comment or problem definition line
-		if (c == 'c' || c == 'p') {
-			// skip this line
-			while(c != '\n') {
-				c = fgetc(f);
-			}
+      // comment or problem definition line
+      if (c == 'c' || c == 'p') {
+         while (c != '\n' && c != EOF) {
+            c = f.next();
+         }
 
-			continue;
-		}
-		// whitespace
-		if (isspace(c))
-			continue;
-		
-		// negative
-		if (c == '-') {
-			neg = true;
-			continue;
-		}
+         continue;
+      }
 
-		// number
-		if (isdigit(c)) {
-			int num = c - '0';
+      if (c == '-') {
+         neg = true;
+         continue;
+      }
 
-			c = fgetc(f);
+      if (isdigit(c)) {
+         int num = c - '0';
 
-			while (isdigit(c)) {
-				num = num*10 + (c-'0');
-				c = fgetc(f);
-			}
+         c = f.next();
 
-			if (neg) {
-				num *= -1;
-			}
+         while (isdigit(c)) {
+            num = num*10 + (c-'0');
+            c = f.next();
+         }
 
-			neg = false;
+         nbVars = max(nbVars, num);
 
-			if (num != 0) {
-				cls.push_back(num);
-			} else {
-				ClauseExchange * ncls = ClauseManager::allocClause(cls.size());
+         if (neg) {
+            num *= -1;
+         }
 
-				for (size_t i=0; i<cls.size(); i++) {
-				   ncls->lits[i] = cls[i];
-				}
+         neg = false;
 
-				ClauseManager::increaseClause(ncls, solvers.size());
+         if (num != 0) {
+            cls.push_back(num);
+         } else {
+            onClause(cls);
+            cls.clear();
+         }
+      }
+   }
 
-				clauses.push_back(ncls);
+   gzclose(in);
 
-				cls.clear();
-			}
-		}
-	}
+   return true;
+}
+
+bool loadFormulaToSolvers(vector<SolverInterface*> solvers,
+                          const char* filename)
+{
+   vector<ClauseExchange *> clauses;
+
+   int nbVars;
+
+   bool ok = parseFormula(filename, nbVars, [&](const vector<int> & cls) {
+      ClauseExchange * ncls = ClauseManager::allocClause(cls.size());
 
-	fclose(f);
+      for (size_t i = 0; i < cls.size(); i++) {
+         ncls->lits[i] = cls[i];
+      }
 
-	for (size_t i = 0; i < solvers.size(); i++) {
-		solvers[i]->addInitialClauses(clauses);
-	}
+      ClauseManager::increaseClause(ncls, solvers.size());
 
-	return true;
+      clauses.push_back(ncls);
+   });
+
+   if (ok == false)
+      return false;
+
+   for (size_t i = 0; i < solvers.size(); i++) {
+      solvers[i]->addInitialClauses(clauses);
+   }
+
+   return true;
+}
+
+bool readFormula(const char* filename, vector<vector<int> > & clauses,
+                 int & nbVars)
+{
+   return parseFormula(filename, nbVars, [&](const vector<int> & cls) {
+      clauses.push_back(cls);
+   });
 }
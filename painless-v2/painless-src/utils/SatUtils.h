@@ -27,3 +27,7 @@ void printModel(vector<int> & model);
 /// Load the cnf contains in the file to the solver.
 bool loadFormulaToSolvers(vector<SolverInterface*> solvers,
                           const char* filename);
+
+/// Read the cnf contained in the file, nbVars is the highest variable.
+bool readFormula(const char* filename, vector<vector<int> > & clauses,
+                 int & nbVars);
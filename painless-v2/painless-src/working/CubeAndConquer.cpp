@@ -23,7 +23,9 @@
 #include "../solvers/SolverInterface.h"
 #include "../utils/Logger.h"
 #include "../utils/Parameters.h"
+#include "../utils/SatUtils.h"
 #include "../working/CubeAndConquer.h"
+#include "../working/LookaheadCuber.h"
 #include "../working/SequentialWorker.h"
 
 #include <algorithm>
@@ -185,17 +187,78 @@ void * mainMasterCubeAndConquer(void * arg)
    return NULL;
 }
 
+void * mainLookaheadCubeAndConquer(void * arg)
+{
+   CubeAndConquer * cc = (CubeAndConquer *)arg;
+
+   // Wait until a job is notify by solve method
+   pthread_mutex_lock(&cc->mutexStart);
+
+   if (cc->waitJob == true) {
+      pthread_cond_wait(&cc->mutexCondStart, &cc->mutexStart);
+   }
+
+   pthread_mutex_unlock(&cc->mutexStart);
+
+   vector<vector<int> > clauses;
+   int nbVars;
+
+   if (readFormula(Parameters::getFilename(), clauses, nbVars) == false) {
+      log(0, "Lookahead cannot read the formula\n");
+      return NULL;
+   }
+
+   double start = getAbsoluteTime();
+
+   LookaheadCuber cuber(clauses, nbVars);
+   clauses.clear();
+
+   bool sat = cuber.makeCubes(cc->actualCube, cc->maxCubes, cc->cubes);
+
+   log(1, "Lookahead made %d cubes in %f s, %d failed literals, %d refuted" \
+       " leaves\n", (int)cc->cubes.size(), getAbsoluteTime() - start,
+       cuber.nbFailed, cuber.nbRefuted);
+
+   if (sat == false) {
+      cc->join(cc, UNSAT, vector<int>());
+      return NULL;
+   }
+
+   pthread_mutex_lock(&cc->mutexCubes);
+
+   cc->nJobs = cc->cubes.size();
+   cc->next  = 0;
+   cc->closedCubes.assign(cc->cubes.size(), false);
+   cc->cubeWorkers.assign(cc->cubes.size(), 0);
+
+   pthread_mutex_unlock(&cc->mutexCubes);
+
+   for (size_t i = 0; i < cc->slaves.size(); i++) {
+      cc->nextCube((SequentialWorker *)cc->slaves[i], false);
+   }
+
+   return NULL;
+}
+
 CubeAndConquer::CubeAndConquer(int maxCpus_)
 {
    maxCpus = maxCpus_;
    maxNodes = 8 * maxCpus;
 
+   cubeMode = Parameters::getIntParam("cube-mode", 1);
+   maxCubes = Parameters::getIntParam("cube-count", 32 * maxCpus);
+
    pthread_mutex_init(&mutexStart, NULL);
+   pthread_mutex_init(&mutexCubes, NULL);
    pthread_cond_init (&mutexCondStart, NULL);
 
    waitJob = true;
 
-   master = new Thread(mainMasterCubeAndConquer, this);
+   if (cubeMode == 2) {
+      master = new Thread(mainLookaheadCubeAndConquer, this);
+   } else {
+      master = new Thread(mainMasterCubeAndConquer, this);
+   }
 }
 
 CubeAndConquer::~CubeAndConquer()
@@ -204,6 +267,7 @@ CubeAndConquer::~CubeAndConquer()
    delete master;
 
    pthread_mutex_destroy(&mutexStart);
+   pthread_mutex_destroy(&mutexCubes);
    pthread_cond_destroy (&mutexCondStart);
 }
 
@@ -224,10 +288,22 @@ CubeAndConquer::solve(const vector<int> & cube)
 CubeAndConquer::join(WorkingStrategy * strat, SatResult res,
       const vector<int> & model)
 {
-   if (res == UNKNOWN || strategyEnding)
+   if (strategyEnding)
+      return;
+
+   // An interrupted worker whose cube is closed by another one, or an UNSAT
+   // cube
+   if (cubeMode == 2 && res != SAT && strat != this) {
+      if (nextCube((SequentialWorker *)strat, res == UNSAT))
+         return;
+
+      res = UNSAT;
+   }
+
+   if (res == UNKNOWN)
       return;
 
-   if (res == UNSAT && strat != slaves[0]) {
+   if (cubeMode == 1 && res == UNSAT && strat != slaves[0]) {
       nJobs--;
 
       if (nJobs.load() > 0) {
@@ -252,8 +328,10 @@ CubeAndConquer::join(WorkingStrategy * strat, SatResult res,
       globalEnding = true;
       finalResult  = res;
 
-      SequentialWorker * winner = (SequentialWorker *)strat;
-      log(0, "Winner: %d\n", winner->solver->id);
+      if (strat != this) {
+         SequentialWorker * winner = (SequentialWorker *)strat;
+         log(0, "Winner: %d\n", winner->solver->id);
+      }
 
       if (res == SAT) {
          finalModel = model;
@@ -263,6 +341,75 @@ CubeAndConquer::join(WorkingStrategy * strat, SatResult res,
    }
 }
 
+   bool
+CubeAndConquer::nextCube(SequentialWorker * worker, bool closed)
+{
+   pthread_mutex_lock(&mutexCubes);
+
+   int id = -1;
+   if (workerCubes.count(worker)) {
+      id = workerCubes[worker];
+      cubeWorkers[id]--;
+      workerCubes.erase(worker);
+   }
+
+   if (closed && id >= 0 && closedCubes[id] == false) {
+      closedCubes[id] = true;
+      nJobs--;
+
+      log(1, "UNSAT cube %d resolved, %d left\n", id, nJobs.load());
+
+      // The workers helping on this cube go to another one
+      for (auto & helper : workerCubes) {
+         if (helper.second == id)
+            helper.first->setInterrupt();
+      }
+   }
+
+   if (nJobs.load() == 0) {
+      pthread_mutex_unlock(&mutexCubes);
+      return false;
+   }
+
+   // Interrupted for another reason, the cube is resumed
+   if (closed == false && id >= 0 && closedCubes[id] == false) {
+      cubeWorkers[id]++;
+      workerCubes[worker] = id;
+      worker->solve(cubes[id]);
+
+      pthread_mutex_unlock(&mutexCubes);
+      return true;
+   }
+
+   id = -1;
+   while (next.load() < cubes.size() && id < 0) {
+      if (closedCubes[next] == false)
+         id = next;
+      next++;
+   }
+
+   // Every cube is given, help on the open cube with the fewest workers
+   if (id < 0) {
+      for (size_t i = 0; i < cubes.size(); i++) {
+         if (closedCubes[i] == false &&
+             (id < 0 || cubeWorkers[i] < cubeWorkers[id]))
+            id = i;
+      }
+   }
+
+   if (id < 0) {
+      worker->setInterrupt();
+   } else {
+      cubeWorkers[id]++;
+      workerCubes[worker] = id;
+      worker->solve(cubes[id]);
+   }
+
+   pthread_mutex_unlock(&mutexCubes);
+
+   return true;
+}
+
    void
 CubeAndConquer::setInterrupt()
 {
@@ -23,10 +23,19 @@
 #include "../working/SequentialWorker.h"
 #include "../working/WorkingStrategy.h"
 
+#include <map>
+
 using namespace std;
 
 static void * mainMasterCubeAndConquer(void * arg);
 
+static void * mainLookaheadCubeAndConquer(void * arg);
+
+/// Cube and conquer, with two modes. In cube-mode 1, the sub-problems are
+/// divided in rounds: a division clones the solver and adds the division
+/// literal as a unit clause. In cube-mode 2, the cubes are made at once by a
+/// lookahead, then solved under assumptions by the persistent slaves. Once
+/// every cube is given, the idle slaves help on the open cubes.
 class CubeAndConquer : public WorkingStrategy
 {
 public:
@@ -53,6 +62,12 @@ public:
 protected:
    friend void * mainMasterCubeAndConquer(void * arg); 
 
+   friend void * mainLookaheadCubeAndConquer(void * arg);
+
+   /// In cube-mode 2, close the cube of the worker if it is UNSAT and give it
+   /// another one. Return false if every cube is closed.
+   bool nextCube(SequentialWorker * worker, bool closed);
+
    atomic<bool> strategyEnding;
    
    atomic<bool> waitJob;
@@ -73,4 +88,19 @@ protected:
 
    vector<SequentialWorker *> over;
    vector<SequentialWorker *> workers;
+
+   int cubeMode;
+
+   /// Number of cubes made by the lookahead.
+   int maxCubes;
+
+   /// Protects the cubes of cube-mode 2.
+   pthread_mutex_t mutexCubes;
+
+   vector<vector<int> > cubes;
+   vector<bool> closedCubes;
+
+   /// Number of workers on each cube, and the cube of each worker.
+   vector<int> cubeWorkers;
+   map<SequentialWorker *, int> workerCubes;
 };
@@ -0,0 +1,409 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2021
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#include "../comm/MpiComm.h"
+#include "../utils/Logger.h"
+#include "../utils/System.h"
+#include "../working/DistributedDivideAndConquer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <stdlib.h>
+
+using namespace std;
+
+/// Attempts to get a division variable that is not in the cube.
+#define MAX_DIVISION_ATTEMPTS 8
+
+void * mainMasterDistributed(void * arg)
+{
+   DistributedDivideAndConquer * dc = (DistributedDivideAndConquer *)arg;
+
+   unique_lock<mutex> guard(dc->lock);
+
+   while (globalEnding == false && dc->strategyEnding == false) {
+      // A rank without busy workers has nothing to give
+      if (dc->startTimes.empty()) {
+         for (int thief : dc->thieves) {
+            MpiComm::getInstance()->sendNoCube(thief);
+         }
+         dc->thieves.clear();
+      }
+
+      double wait = dc->requestSplits();
+
+      if (dc->size > 1 && dc->startTimes.empty() && dc->queue.empty() &&
+          dc->idle.empty() == false && dc->stealing == false)
+      {
+         double delta = dc->nextSteal - getAbsoluteTime();
+
+         if (delta <= 0) {
+            int victim = (dc->rank + 1 + rand() % (dc->size - 1)) % dc->size;
+            log(2, "Rank %d steals from rank %d\n", dc->rank, victim);
+
+            MpiComm::getInstance()->sendStealRequest(victim);
+            dc->stealing = true;
+         } else {
+            wait = min(wait, delta);
+         }
+      }
+
+      dc->cond.wait_for(guard, chrono::microseconds((int)(wait * 1000000)));
+   }
+
+   log(1, "Rank %d: %d divisions, %d cubes stolen, %d given, %d failed" \
+       " steals, %d cubes closed\n", dc->rank, dc->nSplits.load(),
+       dc->nStolen.load(), dc->nGiven.load(), dc->nFailedSteals.load(),
+       dc->nClosed.load());
+
+   return NULL;
+}
+
+DistributedDivideAndConquer::DistributedDivideAndConquer(int rank, int size)
+{
+   this->rank = rank;
+   this->size = size;
+
+   strategyEnding = false;
+   master         = NULL;
+
+   stealing  = false;
+   nextSteal = 0;
+   backoff   = STEAL_MIN_BACKOFF;
+
+   nSplits       = 0;
+   nStolen       = 0;
+   nGiven        = 0;
+   nFailedSteals = 0;
+   nClosed       = 0;
+
+   // Rank 0 gets the results of every rank
+   MpiComm * comm = MpiComm::getInstance();
+   if (rank == 0) {
+      for (int i = 0; i < size; i++) {
+         comm->registerParentWorkingStrategy(this);
+      }
+   }
+   comm->registerChildWorkingStrategy(this);
+   comm->registerStealingStrategy(this);
+}
+
+DistributedDivideAndConquer::~DistributedDivideAndConquer()
+{
+   if (master) {
+      master->join();
+      delete master;
+   }
+
+   for (size_t i = 0; i < slaves.size(); i++) {
+      delete slaves[i];
+   }
+}
+
+void
+DistributedDivideAndConquer::solve(const vector<int> & cube)
+{
+   {
+      lock_guard<mutex> guard(lock);
+
+      idle = slaves;
+
+      // The other ranks start by stealing
+      if (rank == 0) {
+         rootCube = cube;
+         dispatch(cube);
+      }
+   }
+
+   master = new Thread(mainMasterDistributed, this);
+}
+
+void
+DistributedDivideAndConquer::join(WorkingStrategy * strat, SatResult res,
+                                  const vector<int> & model)
+{
+   if (strat == this) {
+      // Result of a rank, on rank 0
+      if (globalEnding)
+         return;
+
+      setInterrupt();
+
+      finalResult = res;
+      if (res == SAT) {
+         finalModel = model;
+      }
+      globalEnding = true;
+      return;
+   }
+
+   if (globalEnding || strategyEnding)
+      return;
+
+   if (res == SAT) {
+      setInterrupt();
+
+      MpiComm::getInstance()->reportResult(res, model);
+      return;
+   }
+
+   unique_lock<mutex> guard(lock);
+
+   if (strategyEnding)
+      return;
+
+   if (res == UNKNOWN) {
+      vector<int> cube = cubes[strat];
+
+      if (splitting.erase(strat) == 0) {
+         // Not interrupted by this strategy
+         assign(strat, cube);
+         return;
+      }
+
+      int var = 0;
+      for (int i = 0; i < MAX_DIVISION_ATTEMPTS && var == 0; i++) {
+         var = abs(strat->getDivisionVariable());
+         if (find(cube.begin(), cube.end(), var)  != cube.end() ||
+             find(cube.begin(), cube.end(), -var) != cube.end())
+            var = 0;
+      }
+
+      if (var == 0) {
+         log(2, "Rank %d: no division variable for %p\n", rank, strat);
+         assign(strat, cube);
+         return;
+      }
+
+      nSplits++;
+      log(2, "Rank %d: %p is splitting on %d\n", rank, strat, var);
+
+      vector<int> other = cube;
+      cube.push_back(var);
+      other.push_back(-var);
+
+      assign(strat, cube);
+      dispatch(other);
+      return;
+   }
+
+   // UNSAT
+   vector<int> closing = cubes[strat];
+
+   splitting.erase(strat);
+   startTimes.erase(strat);
+   strat->setInterrupt();
+
+   if (queue.empty() == false) {
+      assign(strat, queue.back());
+      queue.pop_back();
+   } else {
+      idle.push_back(strat);
+      cond.notify_one();
+   }
+
+   guard.unlock();
+
+   if (rank == 0) {
+      closeCube(closing);
+   } else {
+      MpiComm::getInstance()->sendClosedCube(closing);
+   }
+}
+
+void
+DistributedDivideAndConquer::assign(WorkingStrategy * worker,
+                                    const vector<int> & cube)
+{
+   cubes[worker]      = cube;
+   startTimes[worker] = getAbsoluteTime();
+
+   worker->solve(cube);
+}
+
+void
+DistributedDivideAndConquer::dispatch(const vector<int> & cube)
+{
+   if (idle.empty() == false) {
+      WorkingStrategy * worker = idle.back();
+      idle.pop_back();
+      assign(worker, cube);
+   } else if (thieves.empty() == false) {
+      MpiComm::getInstance()->sendAssumption(cube, thieves.front());
+      thieves.pop_front();
+      nGiven++;
+   } else {
+      queue.push_back(cube);
+   }
+}
+
+double
+DistributedDivideAndConquer::requestSplits()
+{
+   double wait   = STEAL_MAX_BACKOFF;
+   int    demand = idle.size() + thieves.size() - splitting.size();
+
+   while (demand > 0) {
+      WorkingStrategy * oldest = NULL;
+      double            start  = 0;
+
+      for (auto & busy : startTimes) {
+         if (splitting.count(busy.first) == 0 &&
+             (oldest == NULL || busy.second < start)) {
+            oldest = busy.first;
+            start  = busy.second;
+         }
+      }
+
+      if (oldest == NULL)
+         break;
+
+      double delta = start + STEAL_MIN_SLICE - getAbsoluteTime();
+      if (delta > 0) {
+         wait = min(wait, delta);
+         break;
+      }
+
+      splitting.insert(oldest);
+      oldest->setInterrupt();
+      demand--;
+   }
+
+   return wait;
+}
+
+void
+DistributedDivideAndConquer::stealRequest(int thief)
+{
+   lock_guard<mutex> guard(lock);
+
+   if (queue.empty() == false) {
+      MpiComm::getInstance()->sendAssumption(queue.front(), thief);
+      queue.pop_front();
+      nGiven++;
+   } else if (startTimes.empty() || strategyEnding) {
+      MpiComm::getInstance()->sendNoCube(thief);
+   } else {
+      // Served by the next split
+      thieves.push_back(thief);
+      cond.notify_one();
+   }
+}
+
+void
+DistributedDivideAndConquer::stealAnswer(bool found, const vector<int> & cube)
+{
+   lock_guard<mutex> guard(lock);
+
+   stealing = false;
+
+   if (found) {
+      log(2, "Rank %d stole a cube of size %d\n", rank, (int)cube.size());
+      nStolen++;
+      backoff = STEAL_MIN_BACKOFF;
+      dispatch(cube);
+   } else {
+      nFailedSteals++;
+      nextSteal = getAbsoluteTime() + backoff;
+      backoff   = min(backoff * 2, STEAL_MAX_BACKOFF);
+   }
+
+   cond.notify_one();
+}
+
+void
+DistributedDivideAndConquer::closeCube(const vector<int> & cube)
+{
+   lock_guard<mutex> guard(closedLock);
+
+   nClosed++;
+
+   // A cube and its sibling close their parent
+   vector<int> parent = cube;
+   while (parent.size() > rootCube.size()) {
+      parent.back() = -parent.back();
+
+      auto sibling = closed.find(parent);
+      if (sibling == closed.end()) {
+         parent.back() = -parent.back();
+         break;
+      }
+
+      closed.erase(sibling);
+      parent.pop_back();
+   }
+
+   if (parent.size() > rootCube.size()) {
+      closed.insert(parent);
+      return;
+   }
+
+   log(1, "Rank 0: the root cube is closed after %d cubes\n", nClosed.load());
+   MpiComm::getInstance()->reportResult(UNSAT, vector<int>());
+}
+
+void
+DistributedDivideAndConquer::setInterrupt()
+{
+   // The workers are not given cubes anymore
+   {
+      lock_guard<mutex> guard(lock);
+      strategyEnding = true;
+      cond.notify_one();
+   }
+
+   for (size_t i = 0; i < slaves.size(); i++) {
+      slaves[i]->setInterrupt();
+   }
+}
+
+void
+DistributedDivideAndConquer::unsetInterrupt()
+{
+   for (size_t i = 0; i < slaves.size(); i++) {
+      slaves[i]->unsetInterrupt();
+   }
+}
+
+void
+DistributedDivideAndConquer::waitInterrupt()
+{
+   for (size_t i = 0; i < slaves.size(); i++) {
+      slaves[i]->waitInterrupt();
+   }
+}
+
+//Not used actually
+int
+DistributedDivideAndConquer::getDivisionVariable()
+{
+   return 0;
+}
+
+//Not used actually
+void
+DistributedDivideAndConquer::setPhase(int var, bool value)
+{
+}
+
+//Not used actually
+void
+DistributedDivideAndConquer::bumpVariableActivity(int var, int times)
+{
+}
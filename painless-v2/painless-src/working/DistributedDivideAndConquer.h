@@ -0,0 +1,142 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2021
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include "../utils/Threading.h"
+#include "../working/WorkingStrategy.h"
+
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <set>
+
+using namespace std;
+
+/// Minimum time in second a worker solves its cube before it is split.
+#define STEAL_MIN_SLICE 0.5
+
+/// Bounds of the time in second an idle rank waits before it steals again
+/// after a failed attempt.
+#define STEAL_MIN_BACKOFF 0.001
+#define STEAL_MAX_BACKOFF 0.1
+
+static void * mainMasterDistributed(void * arg);
+
+/// Divide and conquer over the ranks.
+///
+/// The workers of a rank are split on demand, when a local worker is idle or
+/// when another rank asks for a cube. The cubes that nobody asked for yet
+/// wait in the queue of the rank: its own workers take the newest ones, the
+/// other ranks steal the oldest, i.e., the largest ones. A rank whose workers
+/// are all idle steals from a random rank. The guiding paths of the UNSAT
+/// cubes are reported to rank 0, which merges the sibling cubes: the formula
+/// is UNSAT once the root cube is closed.
+class DistributedDivideAndConquer : public WorkingStrategy
+{
+public:
+   DistributedDivideAndConquer(int rank, int size);
+
+   ~DistributedDivideAndConquer();
+
+   void solve(const vector<int> & cube);
+
+   void join(WorkingStrategy * strat, SatResult res,
+             const vector<int> & model);
+
+   void setInterrupt();
+
+   void unsetInterrupt();
+
+   void waitInterrupt();
+
+   int getDivisionVariable();
+
+   void setPhase(int var, bool value);
+
+   void bumpVariableActivity(int var, int times);
+
+   /// A rank asks for a cube, called by the comm thread.
+   void stealRequest(int thief);
+
+   /// Answer to the steal request of this rank, called by the comm thread.
+   void stealAnswer(bool found, const vector<int> & cube);
+
+   /// A cube is UNSAT, called on rank 0 only.
+   void closeCube(const vector<int> & cube);
+
+protected:
+   friend void * mainMasterDistributed(void * arg);
+
+   /// Start a worker on a cube.
+   void assign(WorkingStrategy * worker, const vector<int> & cube);
+
+   /// Give a new cube to an idle worker, else to a thief, else queue it.
+   void dispatch(const vector<int> & cube);
+
+   /// Interrupt the longest running workers to split them, one per idle
+   /// worker or thief. Return the time in second before the next one can be
+   /// split.
+   double requestSplits();
+
+   int rank;
+   int size;
+
+   atomic<bool> strategyEnding;
+
+   Thread * master;
+
+   /// Protects the state of the workers, the queue and the thieves.
+   mutex lock;
+
+   /// Wakes up the master when the demand changes.
+   condition_variable cond;
+
+   vector<WorkingStrategy *> idle;
+
+   /// Busy workers and the time they started their cube.
+   map<WorkingStrategy *, double> startTimes;
+
+   /// Busy workers interrupted to be split.
+   set<WorkingStrategy *> splitting;
+
+   map<WorkingStrategy *, vector<int> > cubes;
+
+   deque<vector<int> > queue;
+
+   /// Ranks waiting for a cube of this rank.
+   deque<int> thieves;
+
+   /// A steal request is in flight, and when the next one can be sent.
+   bool stealing;
+   double nextSteal;
+   double backoff;
+
+   /// Closed cubes whose sibling is not closed yet, on rank 0.
+   vector<int> rootCube;
+   set<vector<int> > closed;
+   mutex closedLock;
+
+   atomic<int> nSplits;
+   atomic<int> nStolen;
+   atomic<int> nGiven;
+   atomic<int> nFailedSteals;
+   atomic<int> nClosed;
+};
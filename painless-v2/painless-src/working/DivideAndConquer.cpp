@@ -24,160 +24,47 @@
 #include "../solvers/SolverFactory.h"
 #include "../painless.h"
 
-#include <unistd.h>
 #include <algorithm>
+#include <chrono>
 
-#define TIME_BEFORE_INTERRUPTING 2 //in s
+/// Bounds of the slice in second, it follows the mean time of the UNSAT cubes.
+#define MIN_SLICE 0.05
+#define MAX_SLICE 2
 
+/// Weight of the last UNSAT cube in the mean time of the cubes.
+#define SLICE_DECAY 0.125
 
-using namespace std;
+/// Attempts to get a division variable that is not in the cube.
+#define MAX_DIVISION_ATTEMPTS 8
 
-template<typename T>
-static bool getHeadFromVector(vector<T *> & vec, T ** ws)
-{
-   if(vec.size() == 0)
-      return false;
-   *ws = vec[0];
-   vec.erase(vec.begin());
 
-   return true;
-}
+using namespace std;
 
-template<typename T>
-static bool removeFromVector(vector<T *> & vec, T * ws)
+static string formatTimes(const char * title, vector<double> & times)
 {
-   for(int i = 0; i < vec.size(); i++) {
-      if(vec[i] == ws) {
-         vec.erase(vec.begin() + i);
-         return true;
+   string logString = string(title) + ":\nc ";
+   for(int i = 0; i < times.size(); i++) {
+      if(i % 8 == 0 && i != 0) {
+         logString.append("\nc ");
       }
+      logString.append(to_string(times[i]));
+      logString.append(" ");
    }
 
-   return false;
-}
-
-template<typename T>
-static bool addOnceToVectorTail(vector<T *> & vec, T * ws)
-{
-   for(int i = 0; i < vec.size(); i++) {
-      if(vec[i] == ws)
-         return false;
-   }
-   vec.push_back(ws);
-
-   return true;
-}
-
-template<typename T>
-static bool addOnceToVectorHead(vector<T *> & vec, T * ws)
-{
-   for(int i = 0; i < vec.size(); i++) {
-      if(vec[i] == ws)
-         return false;
-   }
-   vec.insert(vec.begin(), ws);
-
-   return true;
+   return logString;
 }
 
-template<typename T>
-static bool doesVectorContain(vector<T *> & vec, T * ws)
-{
-   for(int i = 0; i < vec.size(); i++) {
-      if(vec[i] == ws)
-         return true;
-   }
-
-   return false;
-}
-
-// Copy every element from source to target
-template<typename T>
-static inline void mergeVector(vector<T>& source, vector<T> & target)
-{
-   target.insert(target.end(), source.begin(), source.end());
-}
-
-
 void * mainMasterDivideAndConquer(void * arg)
 {
    DivideAndConquer * dc = (DivideAndConquer *)arg;
 
-   pthread_mutex_lock(&dc->mutexStart); //Wait for the beginning.
-
-   if(dc->waitJob == true) {
-      log(0, "Thread Master is waiting for beginning.\n");
-      pthread_cond_wait(&dc->mutexCondStart, &dc->mutexStart);
-   }
-
-   pthread_mutex_unlock(&dc->mutexStart);
-
-   int size = dc->slaves.size();
-   for(int i = 0; i < size; i++) {
-      // Initially, every slave is waiting for a job.
-      dc->overs.push_back(dc->slaves[i]);
-      // Every slave has the same cube from master.
-      dc->cubes[dc->slaves[i]] = vector<int>(dc->actualCube);
-   }
-
-   WorkingStrategy * actualWorker, * actualOver;
-
-   getHeadFromVector(dc->overs, &actualWorker);
-   dc->workers.push_back(actualWorker);
-
-   dc->nWorkers++;
-   dc->times[actualWorker] = getAbsoluteTime();
-   actualWorker->solve(dc->cubes[actualWorker]); //We launch one SW
-
-   log(0, "Master has started first worker and is now waiting and managing" \
-       " requests.\n");
+   unique_lock<mutex> guard(dc->lock);
 
+   // The workers split themselves, the master only handles the deadlines
    while(globalEnding == false && dc->strategyEnding == false) {
+      double wait = dc->requestSplits();
 
-      pthread_mutex_lock(&dc->mutexListsWorkers);
-
-      while(dc->overs.empty() || dc->workers.empty()){
-         log(2,"Thread Master is waiting for work.\n");
-         pthread_cond_wait(&dc->mutexCondLists, &dc->mutexListsWorkers);
-      }
-
-      // If there is no longer workers, the problem is solved
-      if(dc->nWorkers.load() == 0){
-         pthread_mutex_unlock(&dc->mutexListsWorkers);
-         break;
-      }
-
-      log(2, "Master has some work\n");
-      actualWorker = dc->workers[0];
-
-      double delta = dc->times[actualWorker] +
-                     TIME_BEFORE_INTERRUPTING - getAbsoluteTime();
-
-      // Workers are working for too short, master will wait until the
-      // TIME_BEFORE_INTERRUPTING is reached.
-      if(delta > 0){
-         log(2, "Master: workers are working for too short,I will sleep %f " \
-             " sec\n", delta);
-
-         pthread_mutex_unlock(&dc->mutexListsWorkers);
-
-         usleep((int)(delta * 1000000));
-         continue;
-      }
-
-      getHeadFromVector(dc->overs,&actualOver);
-      dc->workers.erase(dc->workers.begin());
-
-      addOnceToVectorTail(dc->workersSplitting,actualWorker);
-      addOnceToVectorTail(dc->oversSplitting,actualOver);
-
-      log(2,"Master Interrupts %p and added %p to splitting list\n",
-          actualWorker,actualOver);
-
-      //Request the SW to stop but we don't wait for it.
-      actualWorker->setInterrupt();
-
-      pthread_mutex_unlock(&dc->mutexListsWorkers);
+      dc->cond.wait_for(guard, chrono::microseconds((int)(wait * 1000000)));
    }
 
    log(2, "Master Thread is done.\n");
@@ -189,250 +76,407 @@ DivideAndConquer::DivideAndConquer()
    cloneStrategy    = Parameters::getIntParam("copy-mode", 1);
    divisionStrategy = Parameters::getIntParam("split-heur", 1);
 
-   pthread_mutex_init(&mutexStart, NULL);
-   pthread_mutex_init(&mutexListsWorkers,NULL);
-   pthread_mutex_init(&mutexFirstSolution,NULL);
-
-   pthread_cond_init(&mutexCondStart, NULL);
-   pthread_cond_init(&mutexCondLists, NULL);
-
    strategyEnding = false;
+   master         = NULL;
 
-   nWorkers            = 0;
+   nCubes              = 0;
    nDivisions          = 0;
    nCancelledDivisions = 0;
+   nStolen             = 0;
 
-   waitJob = true;
-
-   master = new Thread(mainMasterDivideAndConquer, this);
+   slice    = MIN_SLICE;
+   idleTime = 0;
 }
 
 DivideAndConquer::~DivideAndConquer()
 {
-   master->join();
-   delete master;
+   if (master) {
+      master->join();
+      delete master;
+   }
+
+   for (auto & spares : tasks) {
+      for (DivideAndConquerTask & task : spares.second) {
+         if (task.solver)
+            task.solver->release();
+      }
+   }
 
    for (int i = 0; i < slaves.size(); i++) {
       delete slaves[i];
    }
-
-   pthread_mutex_destroy(&mutexStart);
-   pthread_mutex_destroy(&mutexListsWorkers);
-   pthread_mutex_destroy(&mutexFirstSolution);
-
-   pthread_cond_destroy (&mutexCondStart);
-   pthread_cond_destroy(&mutexCondLists);
 }
 
 void
 DivideAndConquer::solve(const vector<int> & cube)
 {
-   actualCube=cube;
+   {
+      lock_guard<mutex> guard(lock);
 
-   waitJob = false;
+      double now = getAbsoluteTime();
+      for (size_t i = 1; i < slaves.size(); i++) {
+         idle.push_back(slaves[i]);
+         idleSince[slaves[i]] = now;
+      }
 
-   pthread_mutex_lock(&mutexStart);
+      // In copy-mode 2, only the first worker has a solver
+      nCubes = 1;
+      assign(slaves[0], {cube, NULL});
+   }
 
-   pthread_cond_signal(&mutexCondStart);
+   master = new Thread(mainMasterDivideAndConquer, this);
 
-   pthread_mutex_unlock(&mutexStart);
+   log(0, "Master has started first worker.\n");
 }
 
 void
 DivideAndConquer::join(WorkingStrategy * current, SatResult res,
                        const vector<int> & model)
 {
+   if (globalEnding || strategyEnding)
+      return;
+
    //If res is UNKNOWN, this slave has been interrupted to split.
-   if (res == UNKNOWN){
-      nDivisions++;
+   if (res == UNKNOWN) {
+      split(current);
+      return;
+   }
 
-      pthread_mutex_lock(&mutexListsWorkers);
+   if (res == UNSAT) {
+      log(1, "An UNSAT sub-problem has been solved by %p\n", current);
 
-      WorkingStrategy * over;
-      getHeadFromVector(oversSplitting, &over);
+      if (closeCube(current) == false)
+         return;
+   }
 
-      removeFromVector(workersSplitting, current);
+   //Only the first slave has to go there, the others must just return.
+   {
+      lock_guard<mutex> guard(lock);
 
-      double divisionTime = getAbsoluteTime();
+      if (strategyEnding)
+         return;
 
-      SolverInterface * currentSolver = ((SequentialWorker *)current)->solver;
-      SolverInterface * overSolver    = ((SequentialWorker *)over)->solver;
+      strategyEnding = true;
+      cond.notify_one();
+   }
 
-      // Create a new solver by copying the current one.
-      if(cloneStrategy == 2) {
-         SolverInterface * cloneSolver =
-            SolverFactory::cloneSolver(currentSolver);
+   for (size_t i = 0; i < slaves.size(); i++) {
+      slaves[i]->setInterrupt(); //Interrupting slaves.
+   }
 
-         if (sharers != NULL) {
-            for (int i = 0; i < nSharers; i++) {
-               sharers[i]->addConsumer(cloneSolver);
-               sharers[i]->addProducer(cloneSolver);
-            }
-         }
+   if(parent == NULL) {
+      globalEnding = true;
+      finalResult  = res;
 
-         ((SequentialWorker *)over)->solver = cloneSolver;
-      }
+      log(0, "DivideAndConquer (%p) found a solution\n", current);
 
-      int var = current->getDivisionVariable();
-      splittingTimesLog.push_back(getAbsoluteTime() - divisionTime);
+      lock_guard<mutex> guard(lock);
 
-      log(1,"Slave %p is splitting for %p, division variable is: %d\n",
-          current, over, var);
+      sort(timesLog.begin(), timesLog.end());
 
-      //Copy the worker's cube to the over
-      cubes[over] = vector<int>(cubes[current]);
+      log(1, "Number of divisions: %d, number of cancelled divisions: %d\n",
+          nDivisions.load(), nCancelledDivisions.load());
+      log(1, "Spares stolen: %d, idle time of the workers: %f s, last" \
+          " slice: %f s\n", nStolen.load(), idleTime, slice);
 
-      cubes[current].push_back(var);
-      cubes[over].push_back(-var);
+      log(1, "%s\n", formatTimes("Times for each work", timesLog).c_str());
+      log(1, "%s\n", formatTimes("Divisions times", splittingTimesLog).c_str());
 
-      workers.push_back(current);
-      workers.push_back(over); //Both WS are now working.
+      if(res == SAT){
+         finalModel= model;
+      }
+
+   }else{
+      parent->join(this,res,model);
+   }
+}
+
+void
+DivideAndConquer::split(WorkingStrategy * current)
+{
+   vector<int> cube;
 
-      nWorkers++;
+   {
+      lock_guard<mutex> guard(lock);
 
-      double actualTime = getAbsoluteTime();
-      times[current]    = actualTime;
-      times[over]       = actualTime;
+      if (strategyEnding)
+         return;
 
-      current->solve(cubes[current]);
-      over->solve(cubes[over]);
+      cube = cubes[current];
 
-      if(!overs.empty()) {
-         // Signal the Master that workers are available to split
-         // (Only if overs are available).
-         pthread_cond_signal(&mutexCondLists);
+      // It stays in splitting until it is split, not to be interrupted again
+      if (splitting.count(current) == 0) {
+         // Not interrupted by this strategy
+         assign(current, {cube, NULL});
+         return;
       }
+   }
+
+   // The worker is stopped, its solver can be read without the lock
+   double divisionTime = getAbsoluteTime();
+
+   DivideAndConquerTask other = {cube, NULL};
+
+   // Taken before the division variable, that consumes the propagation rates
+   if (cloneStrategy == 1 && divisionStrategy != 1) {
+      vector<int> * flipActivity   = NULL;
+      vector<int> * nbPropagations = NULL;
+      vector<int> * nbDecisionVar  = NULL;
+
+      ((SequentialWorker *)current)->solver->getHeuristicData(&flipActivity,
+                                                              &nbPropagations,
+                                                              &nbDecisionVar);
+      if (flipActivity != NULL)
+         other.flipActivity = *flipActivity;
+      if (nbPropagations != NULL)
+         other.nbPropagations = *nbPropagations;
+      if (nbDecisionVar != NULL)
+         other.nbDecisionVar = *nbDecisionVar;
+   }
+
+   int var = 0;
+   for (int i = 0; i < MAX_DIVISION_ATTEMPTS && var == 0; i++) {
+      var = abs(current->getDivisionVariable());
+      if (find(cube.begin(), cube.end(), var)  != cube.end() ||
+          find(cube.begin(), cube.end(), -var) != cube.end())
+         var = 0;
+   }
 
-      pthread_mutex_unlock(&mutexListsWorkers);
+   // Create a new solver by copying the current one.
+   SolverInterface * cloneSolver = NULL;
+   if (cloneStrategy == 2 && var != 0) {
+      cloneSolver =
+         SolverFactory::cloneSolver(((SequentialWorker *)current)->solver);
+   }
+
+   lock_guard<mutex> guard(lock);
 
+   if (strategyEnding) {
+      if (cloneSolver)
+         cloneSolver->release();
       return;
    }
 
-   if(res == UNSAT){
-      log(1, "An UNSAT sub-problem has been solved by %p\n", current);
+   splitting.erase(current);
 
-      pthread_mutex_lock(&mutexListsWorkers);
+   if (var == 0) {
+      log(2, "Slave %p has no division variable\n", current);
+      nCancelledDivisions++;
+      assign(current, {cube, NULL});
+      return;
+   }
 
-      timesLog.push_back(getAbsoluteTime() - times[current]);
+   splittingTimesLog.push_back(getAbsoluteTime() - divisionTime);
+   nDivisions++;
+   nCubes++;
 
-      // If current is in workersSplitting, it means that it was supposed to
-      // split, but it has finished, so it has to cancel the division.
-      if(doesVectorContain(workersSplitting, current)) {
-         log(2, "Slave %p didn't split because it has finished\n", current);
+   other.solver = cloneSolver;
+   other.cube.push_back(-var);
+   cube.push_back(var);
 
-         nCancelledDivisions++;
+   // The other half goes to an idle worker, else it is a spare
+   if (idle.empty() == false) {
+      WorkingStrategy * over = idle.front();
+      idle.pop_front();
 
-         WorkingStrategy * oldOver;
-         getHeadFromVector(oversSplitting, &oldOver);
-         addOnceToVectorHead(overs, oldOver);
-         removeFromVector(workersSplitting, current);
-      }else{
-         removeFromVector(workers, current);
-      }
+      log(1, "Slave %p is splitting for %p, division variable is: %d\n",
+          current, over, var);
 
-      addOnceToVectorTail(overs, current);
+      assign(over, other);
+   } else {
+      log(1, "Slave %p is splitting for its deque, division variable is:" \
+          " %d\n", current, var);
 
-      if(!workers.empty()) {
-         // Signal the master that an over is available to work
-         // (Only if workers are available to split).
-         pthread_cond_signal(&mutexCondLists);
-      }
+      tasks[current].push_back(other);
+   }
 
-      current->setInterrupt();
+   assign(current, {cube, NULL});
 
-      nWorkers--;
+   cond.notify_one();
+}
 
-      if(nWorkers > 0){
-         if(cloneStrategy == 2) {
-            SolverInterface * currentSolver =
-               ((SequentialWorker *)current)->solver;
-            ((SequentialWorker *)current)->solver = NULL;
+bool
+DivideAndConquer::closeCube(WorkingStrategy * current)
+{
+   SolverInterface * released = NULL;
 
-            pthread_mutex_unlock(&mutexListsWorkers);
+   {
+      lock_guard<mutex> guard(lock);
 
-            if(currentSolver == NULL) {
-               return;
-            }
+      if (strategyEnding)
+         return false;
 
-            if (sharers != NULL) {
-               for (int i = 0; i < nSharers; i++) {
-                  sharers[i]->removeConsumer(currentSolver);
-                  sharers[i]->removeProducer(currentSolver);
-               }
-            }
+      double time = getAbsoluteTime() - times[current];
+      timesLog.push_back(time);
 
-            currentSolver->release();
+      // The slice follows the time needed to solve a cube
+      slice = (1 - SLICE_DECAY) * slice + SLICE_DECAY * time;
+      slice = min(max(slice, (double)MIN_SLICE), (double)MAX_SLICE);
 
-            return;
-         }
+      // If current is splitting, it has finished before, so it has to cancel
+      // the division.
+      if (splitting.erase(current)) {
+         log(2, "Slave %p didn't split because it has finished\n", current);
+         nCancelledDivisions++;
+      }
 
-         pthread_mutex_unlock(&mutexListsWorkers);
+      times.erase(current);
 
-         return;
+      if (--nCubes == 0)
+         return true;
+
+      DivideAndConquerTask task;
+      bool found = takeTask(current, task);
+
+      // In copy-mode 2, the solver of the cube is dropped: the spares come
+      // with their own clone.
+      if (cloneStrategy == 2) {
+         current->setInterrupt();
+         released = ((SequentialWorker *)current)->solver;
+         ((SequentialWorker *)current)->solver = NULL;
       }
 
-      pthread_mutex_unlock(&mutexListsWorkers);
-   }
+      if (found) {
+         assign(current, task);
+      } else {
+         current->setInterrupt();
+         idle.push_back(current);
+         idleSince[current] = getAbsoluteTime();
+      }
 
-   pthread_mutex_lock(&mutexFirstSolution);
+      requestSplits();
+      cond.notify_one();
+   }
 
-   if(strategyEnding == true) {
-      pthread_mutex_unlock(&mutexFirstSolution);
-      return;
+   if (released) {
+      shareSolver(released, false);
+      released->release();
    }
 
-   strategyEnding = true;
+   return false;
+}
 
-   //Only the first slave has to go there, the others must just return.
-   for (size_t i = 0; i < slaves.size(); i++) {
-      slaves[i]->setInterrupt(); //Interrupting slaves.
+void
+DivideAndConquer::assign(WorkingStrategy * worker,
+                         const DivideAndConquerTask & task)
+{
+   double now = getAbsoluteTime();
+
+   if (task.solver) {
+      ((SequentialWorker *)worker)->solver = task.solver;
+      shareSolver(task.solver, true);
+   } else if (task.flipActivity.size() || task.nbPropagations.size()) {
+      // The worker is stopped, it continues the branching of the split one
+      vector<int> flipActivity   = task.flipActivity;
+      vector<int> nbPropagations = task.nbPropagations;
+      vector<int> nbDecisionVar  = task.nbDecisionVar;
+
+      ((SequentialWorker *)worker)->solver->setHeuristicData(
+         flipActivity.size()   ? &flipActivity   : NULL,
+         nbPropagations.size() ? &nbPropagations : NULL,
+         nbDecisionVar.size()  ? &nbDecisionVar  : NULL);
    }
 
-   pthread_mutex_unlock(&mutexFirstSolution);
+   auto since = idleSince.find(worker);
+   if (since != idleSince.end()) {
+      idleTime += now - since->second;
+      idleSince.erase(since);
+   }
 
-   if(parent == NULL) {
-      globalEnding = true;
-      finalResult  = res;
+   cubes[worker] = task.cube;
+   times[worker] = now;
 
-      log(0, "DivideAndConquer (%p) found a solution\n", current);
+   worker->solve(task.cube);
+}
 
-      sort(timesLog.begin(), timesLog.end());
+bool
+DivideAndConquer::takeTask(WorkingStrategy * worker,
+                           DivideAndConquerTask & task)
+{
+   deque<DivideAndConquerTask> & own = tasks[worker];
 
-      log(1, "Number of divisions: %d, number of cancelled divisions: %d\n",
-          nDivisions.load(), nCancelledDivisions.load());
+   if (own.empty() == false) {
+      task = own.back();
+      own.pop_back();
+      return true;
+   }
 
-      string logString="Times for each work:\nc ";
-      for(int i = 0; i < timesLog.size(); i++) {
-         if(i % 8 == 0 && i != timesLog.size() && i != 0) {
-            logString.append("\nc ");
-         }
-         logString.append(to_string(timesLog[i]));
-         logString.append(" ");
-      }
-      log(1,"%s\n",logString.c_str());
-
-      logString = string("Divisions times:\nc ");
-      for(int i = 0; i < splittingTimesLog.size(); i++) {
-         if(i % 8 == 0 && i != splittingTimesLog.size() && i != 0) {
-            logString.append("\nc ");
-         }
-         logString.append(to_string(splittingTimesLog[i]));
-         logString.append(" ");
+   WorkingStrategy * victim = NULL;
+   for (auto & busy : times) {
+      if (tasks[busy.first].empty() == false &&
+          (victim == NULL || busy.second < times[victim])) {
+         victim = busy.first;
       }
-      log(1, "%s\n", logString.c_str());
+   }
 
-      if(res == SAT){
-         finalModel= model;
+   if (victim == NULL)
+      return false;
+
+   task = tasks[victim].front();
+   tasks[victim].pop_front();
+   nStolen++;
+
+   return true;
+}
+
+double
+DivideAndConquer::requestSplits()
+{
+   double wait = MAX_SLICE;
+
+   // Spares are useless to a single worker
+   if (slaves.size() < 2 || strategyEnding)
+      return wait;
+
+   double now = getAbsoluteTime();
+
+   for (auto & busy : times) {
+      if (splitting.count(busy.first) || tasks[busy.first].empty() == false)
+         continue;
+
+      double delta = busy.second + slice - now;
+      if (delta > 0) {
+         wait = min(wait, delta);
+         continue;
       }
 
-   }else{
-      parent->join(this,res,model);
+      log(2, "Master Interrupts %p to split it\n", busy.first);
+
+      //Request the SW to stop but we don't wait for it.
+      splitting.insert(busy.first);
+      busy.first->setInterrupt();
+   }
+
+   return wait;
+}
+
+void
+DivideAndConquer::shareSolver(SolverInterface * solver, bool add)
+{
+   if (sharers == NULL)
+      return;
+
+   for (int i = 0; i < nSharers; i++) {
+      if (add) {
+         sharers[i]->addConsumer(solver);
+         sharers[i]->addProducer(solver);
+      } else {
+         sharers[i]->removeConsumer(solver);
+         sharers[i]->removeProducer(solver);
+      }
    }
 }
 
 void
 DivideAndConquer::setInterrupt()
 {
+   // The workers are not split anymore
+   {
+      lock_guard<mutex> guard(lock);
+      strategyEnding = true;
+      cond.notify_one();
+   }
+
    for (size_t i = 0; i < slaves.size(); i++) {
       slaves[i]->setInterrupt();
    }
@@ -23,12 +23,41 @@
 #include "../working/WorkingStrategy.h"
 #include "../utils/Threading.h"
 #include "../working/SequentialWorker.h"
+
+#include <condition_variable>
+#include <deque>
 #include <map>
+#include <mutex>
+#include <set>
 
 using namespace std;
 
 static void * mainMasterDivideAndConquer(void * arg);
 
+/// A cube waiting for a worker, with the solver cloned for it in copy-mode 2.
+struct DivideAndConquerTask
+{
+   vector<int> cube;
+
+   SolverInterface * solver;
+
+   /// Branching statistics of the split solver, given to the worker that
+   /// takes the cube in copy-mode 1. A clone already has them.
+   vector<int> flipActivity;
+   vector<int> nbPropagations;
+   vector<int> nbDecisionVar;
+};
+
+/// Divide and conquer over the local workers.
+///
+/// The scheduling is done by the workers themselves when they join. Every
+/// busy worker keeps a deque of spare cubes, filled when it is split: a worker
+/// whose cube is UNSAT takes the newest spare of its own deque, else steals
+/// the oldest spare of the longest running worker. A worker finding no spare
+/// becomes idle and is given the other half of the next split. A busy worker
+/// without spare is split once it has worked for the slice, which adapts to
+/// the time needed to solve the cubes. The master thread only wakes up the
+/// splits whose slice is not reached yet.
 class DivideAndConquer : public WorkingStrategy
 {
 public:
@@ -54,38 +83,62 @@ public:
    void bumpVariableActivity(int var, int times);
 
 protected:
+   friend void * mainMasterDivideAndConquer(void * arg);
+
+   /// The worker has been interrupted to be split.
+   void split(WorkingStrategy * current);
+
+   /// The cube of the worker is UNSAT, give it another one. Return true if it
+   /// was the last open cube.
+   bool closeCube(WorkingStrategy * current);
+
+   /// Start a worker on a task.
+   void assign(WorkingStrategy * worker, const DivideAndConquerTask & task);
+
+   /// Take a spare for the worker, from its own deque else from the deque of
+   /// the longest running worker. Return false if there is none.
+   bool takeTask(WorkingStrategy * worker, DivideAndConquerTask & task);
+
+   /// Interrupt the busy workers without spare that have worked for the
+   /// slice. Return the time in second before the next one can be split.
+   double requestSplits();
+
+   /// Attach the solver to the sharers, or detach it.
+   void shareSolver(SolverInterface * solver, bool add);
+
    int cloneStrategy;
    int divisionStrategy;
 
    atomic<bool> strategyEnding;
-   atomic<bool> waitJob;
 
    atomic<int> nDivisions; //number of divisions.
    atomic<int> nCancelledDivisions; //number of cancelled divisions.
+   atomic<int> nStolen; //number of spares taken from another worker.
    vector<double> timesLog;
    vector<double> splittingTimesLog;
 
-   friend void * mainMasterDivideAndConquer(void * arg);
-
    Thread * master;
 
-   pthread_mutex_t mutexStart;
-   pthread_mutex_t mutexListsWorkers;
-   pthread_mutex_t mutexFirstSolution;
+   /// Protects the scheduling state, the master waits on the condition for
+   /// the next split.
+   mutex lock;
+   condition_variable cond;
 
-   pthread_cond_t  mutexCondStart;
-   pthread_cond_t mutexCondLists;
+   /// Number of cubes assigned or waiting in a deque, the formula is UNSAT
+   /// when it reaches 0.
+   int nCubes;
 
-   atomic<int> nWorkers;
+   /// Minimum time in second a worker solves its cube before it is split.
+   double slice;
 
-   vector<WorkingStrategy *> overs; //This vector contains WS that has finished working and ready to take another job
-   vector<WorkingStrategy *> workers; //This vector contains WS that are working
+   deque<WorkingStrategy *> idle; //Workers waiting for the next split.
+   set<WorkingStrategy *> splitting; //Workers interrupted to be split.
 
-   vector<WorkingStrategy *> workersSplitting; //This vector contains the workers that will have to split when they join.
-   vector<WorkingStrategy *> oversSplitting;  //This vector contains some overs that will be split soon by a worker in workersSplitting.
-     
-   map<WorkingStrategy *,vector<int>> cubes; //This vector contains the cube for each worker
-   map<WorkingStrategy *,double> times; //The vector contains the absolute time when each worker started solving its actual cube.
+   map<WorkingStrategy *, deque<DivideAndConquerTask> > tasks; //Spares of each worker.
+   map<WorkingStrategy *, vector<int> > cubes; //This map contains the cube for each worker
+   map<WorkingStrategy *, double> times; //The absolute time when each busy worker started solving its actual cube.
 
-   vector<int> actualCube;
+   /// When each idle worker became idle, and the total idle time.
+   map<WorkingStrategy *, double> idleSince;
+   double idleTime;
 };
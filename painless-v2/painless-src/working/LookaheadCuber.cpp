@@ -0,0 +1,315 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2021
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#include "../working/LookaheadCuber.h"
+
+#include <algorithm>
+#include <math.h>
+#include <queue>
+#include <stdlib.h>
+
+using namespace std;
+
+/// Number of free variables probed by the lookahead of a node.
+#define LOOKAHEAD_CANDIDATES 64
+
+LookaheadCuber::LookaheadCuber(const vector<vector<int> > & formula,
+                               int nbVars_)
+{
+   nbVars    = nbVars_;
+   empty     = false;
+   qhead     = 0;
+   nbFailed  = 0;
+   nbRefuted = 0;
+
+   values.resize(nbVars + 1, 0);
+   watches.resize(2 * nbVars + 2);
+
+   vector<double> weights(2 * nbVars + 2, 0);
+
+   for (size_t i = 0; i < formula.size(); i++) {
+      vector<int> cls = formula[i];
+
+      // Remove the duplicated literals and the tautologies
+      sort(cls.begin(), cls.end(), [](int a, int b) {
+         return abs(a) < abs(b) || (abs(a) == abs(b) && a < b);
+      });
+
+      bool tautology = false;
+      size_t k = 0;
+      for (size_t j = 0; j < cls.size(); j++) {
+         if (k > 0 && cls[k - 1] == cls[j])
+            continue;
+         if (k > 0 && cls[k - 1] == -cls[j])
+            tautology = true;
+         cls[k++] = cls[j];
+      }
+      cls.resize(k);
+
+      if (tautology)
+         continue;
+
+      if (cls.size() == 0) {
+         empty = true;
+      } else if (cls.size() == 1) {
+         units.push_back(cls[0]);
+      } else {
+         // The short clauses weigh more, as in march
+         for (int lit : cls) {
+            weights[index(lit)] += pow(5.0, 2.0 - cls.size());
+         }
+
+         watches[index(cls[0])].push_back(clauses.size());
+         watches[index(cls[1])].push_back(clauses.size());
+         clauses.push_back(cls);
+      }
+   }
+
+   vector<double> scores(nbVars + 1, 0);
+   for (int var = 1; var <= nbVars; var++) {
+      double pos = weights[index(var)], neg = weights[index(-var)];
+
+      scores[var] = 1024 * pos * neg + pos + neg;
+
+      if (scores[var] > 0)
+         order.push_back(var);
+   }
+
+   sort(order.begin(), order.end(), [&scores](int a, int b) {
+      return scores[a] > scores[b];
+   });
+}
+
+bool
+LookaheadCuber::makeCubes(const vector<int> & root, int maxCubes,
+                          vector<vector<int> > & cubes)
+{
+   // The open leaves with their number of free variables and their
+   // branching variable
+   vector<vector<int> > nodes;
+   vector<int> vars;
+   priority_queue<pair<int, int> > open;
+
+   vector<int> cube = root;
+   int var;
+
+   if (setCube(cube) == false || lookahead(cube, var) == false)
+      return false;
+
+   nodes.push_back(cube);
+   vars.push_back(var);
+   open.push(make_pair(nbVars - (int)trail.size(), 0));
+
+   while (open.empty() == false && (int)(cubes.size() + open.size()) < maxCubes)
+   {
+      int node = open.top().second;
+      open.pop();
+
+      if (vars[node] == 0) {
+         // Nothing to branch on
+         cubes.push_back(nodes[node]);
+         continue;
+      }
+
+      for (int lit : {vars[node], -vars[node]}) {
+         cube = nodes[node];
+         cube.push_back(lit);
+
+         if (setCube(cube) == false || lookahead(cube, var) == false) {
+            nbRefuted++;
+            continue;
+         }
+
+         nodes.push_back(cube);
+         vars.push_back(var);
+         open.push(make_pair(nbVars - (int)trail.size(), nodes.size() - 1));
+      }
+
+      nodes[node].clear();
+   }
+
+   while (open.empty() == false) {
+      cubes.push_back(nodes[open.top().second]);
+      open.pop();
+   }
+
+   backtrack(0);
+
+   return cubes.empty() == false;
+}
+
+bool
+LookaheadCuber::setCube(const vector<int> & cube)
+{
+   backtrack(0);
+
+   if (empty)
+      return false;
+
+   for (int lit : units) {
+      if (value(lit) == -1)
+         return false;
+      if (value(lit) == 0)
+         enqueue(lit);
+   }
+
+   if (propagate() == false)
+      return false;
+
+   for (int lit : cube) {
+      if (value(lit) == -1)
+         return false;
+      if (value(lit) == 0 && assume(lit) == false)
+         return false;
+   }
+
+   return true;
+}
+
+bool
+LookaheadCuber::lookahead(vector<int> & cube, int & var)
+{
+   bool failed = true;
+
+   // A failed literal changes the node, the candidates are probed again
+   while (failed) {
+      failed = false;
+      var    = 0;
+
+      double best = -1;
+      int    nb   = 0;
+
+      for (size_t i = 0; i < order.size() && nb < LOOKAHEAD_CANDIDATES; i++) {
+         int cand = order[i];
+
+         if (values[cand] != 0)
+            continue;
+
+         nb++;
+
+         size_t size = trail.size();
+
+         int pos = assume(cand) ? trail.size() - size : -1;
+         backtrack(size);
+
+         int neg = assume(-cand) ? trail.size() - size : -1;
+         backtrack(size);
+
+         if (pos < 0 && neg < 0)
+            return false;
+
+         if (pos < 0 || neg < 0) {
+            int lit = pos < 0 ? -cand : cand;
+
+            nbFailed++;
+            failed = true;
+            cube.push_back(lit);
+
+            if (assume(lit) == false)
+               return false;
+
+            continue;
+         }
+
+         // Both sides should propagate a lot
+         double score = 1024.0 * pos * neg + pos + neg;
+         if (score > best) {
+            best = score;
+            var  = cand;
+         }
+      }
+   }
+
+   return true;
+}
+
+bool
+LookaheadCuber::assume(int lit)
+{
+   enqueue(lit);
+
+   return propagate();
+}
+
+bool
+LookaheadCuber::propagate()
+{
+   while (qhead < trail.size()) {
+      int falseLit = -trail[qhead++];
+
+      vector<int> & ws = watches[index(falseLit)];
+
+      size_t i = 0, j = 0;
+      for (; i < ws.size(); i++) {
+         vector<int> & cls = clauses[ws[i]];
+
+         // The false literal is the second one
+         if (cls[0] == falseLit)
+            swap(cls[0], cls[1]);
+
+         if (value(cls[0]) == 1) {
+            ws[j++] = ws[i];
+            continue;
+         }
+
+         // Look for a new literal to watch
+         bool found = false;
+         for (size_t k = 2; k < cls.size(); k++) {
+            if (value(cls[k]) != -1) {
+               swap(cls[1], cls[k]);
+               watches[index(cls[1])].push_back(ws[i]);
+               found = true;
+               break;
+            }
+         }
+
+         if (found)
+            continue;
+
+         ws[j++] = ws[i];
+
+         if (value(cls[0]) == -1) {
+            // Conflict
+            for (i++; i < ws.size(); i++) {
+               ws[j++] = ws[i];
+            }
+            ws.resize(j);
+
+            return false;
+         }
+
+         enqueue(cls[0]);
+      }
+
+      ws.resize(j);
+   }
+
+   return true;
+}
+
+void
+LookaheadCuber::backtrack(size_t size)
+{
+   for (size_t i = size; i < trail.size(); i++) {
+      values[abs(trail[i])] = 0;
+   }
+
+   trail.resize(size);
+   qhead = size;
+}
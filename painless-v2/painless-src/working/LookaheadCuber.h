@@ -0,0 +1,107 @@
+// -----------------------------------------------------------------------------
+// Copyright (C) 2021
+//
+// This file is part of PaInleSS.
+//
+// PaInleSS is free software: you can redistribute it and/or modify it under the
+// terms of the GNU General Public License as published by the Free Software
+// Foundation, either version 3 of the License, or (at your option) any later
+// version.
+//
+// This program is distributed in the hope that it will be useful, but WITHOUT
+// ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+// FOR A PARTICULAR PURPOSE.  See the GNU General Public License for more
+// details.
+//
+// You should have received a copy of the GNU General Public License along with
+// this program.  If not, see <http://www.gnu.org/licenses/>.
+// -----------------------------------------------------------------------------
+
+#pragma once
+
+#include <stdlib.h>
+#include <vector>
+
+using namespace std;
+
+/// Lookahead cuber in the style of march: the formula is split into cubes by
+/// a tree whose decisions are the variables that propagate the most on both
+/// sides. Each node probes the most promising variables: a literal whose
+/// propagation fails is a failed literal, its negation is added to the cube.
+/// The largest leaf, i.e., the one with the most free variables, is split
+/// until the number of cubes is reached.
+class LookaheadCuber
+{
+public:
+   /// Constructor, nbVars is the highest variable of the clauses.
+   LookaheadCuber(const vector<vector<int> > & clauses, int nbVars);
+
+   /// Split the formula under the root cube into at most maxCubes cubes.
+   /// Return false if the formula is UNSAT under the root cube.
+   bool makeCubes(const vector<int> & root, int maxCubes,
+                  vector<vector<int> > & cubes);
+
+   /// Number of failed literals found while cubing.
+   int nbFailed;
+
+   /// Number of leaves refuted while cubing.
+   int nbRefuted;
+
+protected:
+   /// Assign the literals of the cube and propagate them from the root
+   /// level. Return false on conflict.
+   bool setCube(const vector<int> & cube);
+
+   /// Probe the candidates of the current node, add the failed literals to
+   /// the cube and pick the branching variable, 0 if there is none. Return
+   /// false if the node is UNSAT.
+   bool lookahead(vector<int> & cube, int & var);
+
+   /// Assign the literal and propagate it. Return false on conflict.
+   bool assume(int lit);
+
+   bool propagate();
+
+   /// Unassign the literals of the trail after the given size.
+   void backtrack(size_t size);
+
+   inline int value(int lit)
+   {
+      return lit > 0 ? values[lit] : -values[-lit];
+   }
+
+   inline int index(int lit)
+   {
+      return lit > 0 ? 2 * lit : -2 * lit + 1;
+   }
+
+   inline void enqueue(int lit)
+   {
+      values[abs(lit)] = lit > 0 ? 1 : -1;
+      trail.push_back(lit);
+   }
+
+   int nbVars;
+
+   /// Clauses of size 2 and more, their first two literals are watched.
+   vector<vector<int> > clauses;
+
+   /// Clauses watching each literal, see index().
+   vector<vector<int> > watches;
+
+   /// Unit clauses of the formula.
+   vector<int> units;
+
+   /// The formula has an empty clause.
+   bool empty;
+
+   /// Value of each variable: 1 true, -1 false, 0 free.
+   vector<signed char> values;
+
+   vector<int> trail;
+   size_t qhead;
+
+   /// Variables ordered by their weight in the short clauses, the
+   /// candidates of a node are the first free ones.
+   vector<int> order;
+};
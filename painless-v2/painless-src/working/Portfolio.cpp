@@ -17,19 +17,69 @@
 // this program.  If not, see <http://www.gnu.org/licenses/>.
 // -----------------------------------------------------------------------------
 
+#include "../painless.h"
+#include "../solvers/SolverFactory.h"
 #include "../utils/Logger.h"
 #include "../utils/Parameters.h"
+#include "../utils/System.h"
 #include "../working/Portfolio.h"
 #include "../working/SequentialWorker.h"
 
+#include <chrono>
+#include <stdlib.h>
+
 using namespace std;
 
-Portfolio::Portfolio()
+void * mainMasterPortfolio(void * arg)
+{
+   Portfolio * pf = (Portfolio *)arg;
+
+   unique_lock<mutex> guard(pf->lock);
+
+   while (globalEnding == false && pf->strategyEnding == false) {
+      pf->cond.wait_for(guard,
+                        chrono::microseconds((int)(pf->period * 1000000)));
+
+      if (globalEnding || pf->strategyEnding)
+         break;
+
+      pf->rebalance();
+   }
+
+   log(1, "Portfolio: %d solvers replaced by a clone, %d rediversified\n",
+       pf->nClones, pf->nRediversified);
+
+   return NULL;
+}
+
+Portfolio::Portfolio(double period)
 {
+   this->period = period;
+
+   strategyEnding = false;
+   master         = NULL;
+
+   weakest        = NULL;
+   strongest      = NULL;
+   cloning        = false;
+   weakestStopped = false;
+   clone          = NULL;
+
+   nextSeed       = 0;
+   nClones        = 0;
+   nRediversified = 0;
 }
 
 Portfolio::~Portfolio()
 {
+   if (master) {
+      master->join();
+      delete master;
+   }
+
+   if (clone)
+      clone->release();
+
    for (size_t i = 0; i < slaves.size(); i++) {
       delete slaves[i];
    }
@@ -40,18 +90,82 @@ Portfolio::solve(const vector<int> & cube)
 {
    strategyEnding = false;
 
+   if (period > 0) {
+      lock_guard<mutex> guard(lock);
+
+      this->cube = cube;
+      nextSeed   = slaves.size();
+
+      double now = getAbsoluteTime();
+      for (size_t i = 0; i < slaves.size(); i++) {
+         SolverInterface * solver = ((SequentialWorker *)slaves[i])->solver;
+         windows[slaves[i]] = {solver->getStatistics(), now, 0};
+      }
+   }
+
    for (size_t i = 0; i < slaves.size(); i++) {
       slaves[i]->solve(cube);
    }
+
+   if (period > 0) {
+      master = new Thread(mainMasterPortfolio, this);
+   }
 }
 
 void
 Portfolio::join(WorkingStrategy * strat, SatResult res,
                 const vector<int> & model)
 {
-   if (res == UNKNOWN || strategyEnding || globalEnding)
+   if (strategyEnding || globalEnding)
       return;
 
+   if (res == UNKNOWN) {
+      if (period == 0)
+         return;
+
+      unique_lock<mutex> guard(lock);
+
+      if (strategyEnding)
+         return;
+
+      if (strat == strongest) {
+         // The strongest worker is stopped, it can be copied without the lock
+         strongest = NULL;
+         guard.unlock();
+
+         SolverInterface * copy =
+            SolverFactory::cloneSolver(((SequentialWorker *)strat)->solver);
+
+         guard.lock();
+
+         if (strategyEnding) {
+            if (copy)
+               copy->release();
+            return;
+         }
+
+         strat->solve(cube);
+
+         if (copy == NULL)
+            cloning = false;
+
+         if (weakestStopped) {
+            respawn(weakest, copy);
+         } else {
+            clone = copy;
+         }
+      } else if (strat == weakest) {
+         if (cloning && clone == NULL) {
+            // Restarted once the strongest worker is cloned
+            weakestStopped = true;
+         } else {
+            respawn(weakest, clone);
+         }
+      }
+
+      return;
+   }
+
    strategyEnding = true;
 
    setInterrupt();         
@@ -72,9 +186,152 @@ Portfolio::join(WorkingStrategy * strat, SatResult res,
    }
 }
 
+void
+Portfolio::rebalance()
+{
+   // The previous rebalancing is not done
+   if (weakest)
+      return;
+
+   double now = getAbsoluteTime();
+
+   for (size_t i = 0; i < slaves.size(); i++) {
+      PortfolioWindow & window = windows[slaves[i]];
+
+      SolvingStatistics stats = ((SequentialWorker *)slaves[i])->solver->
+                                getStatistics();
+
+      double conflicts = stats.conflicts - window.stats.conflicts;
+      double lbd       = stats.lbdSum - window.stats.lbdSum;
+
+      // Lingeling reports no LBD, its solvers are not rated
+      window.score = -1;
+      if (conflicts > 0 && lbd > 0)
+         window.score = conflicts / (now - window.start) / (lbd / conflicts);
+
+      window.stats = stats;
+      window.start = now;
+
+      log(2, "Portfolio: solver %d scores %f\n",
+          ((SequentialWorker *)slaves[i])->solver->id, window.score);
+   }
+
+   // The LBD of the solvers of different types are not alike (MiniSat counts
+   // the size of the clauses), so only workers of the same type are compared
+   WorkingStrategy * weak   = NULL;
+   WorkingStrategy * strong = NULL;
+
+   for (size_t i = 0; i < slaves.size(); i++) {
+      if (windows[slaves[i]].score < 0)
+         continue;
+
+      SolverType type = ((SequentialWorker *)slaves[i])->solver->type;
+
+      WorkingStrategy * typeWeak   = NULL;
+      WorkingStrategy * typeStrong = NULL;
+
+      for (size_t j = 0; j < slaves.size(); j++) {
+         if (((SequentialWorker *)slaves[j])->solver->type != type ||
+             windows[slaves[j]].score < 0)
+            continue;
+
+         // Each type is compared once, from its first worker
+         if (j < i)
+            break;
+
+         if (typeWeak == NULL ||
+             windows[slaves[j]].score < windows[typeWeak].score)
+            typeWeak = slaves[j];
+         if (typeStrong == NULL ||
+             windows[slaves[j]].score > windows[typeStrong].score)
+            typeStrong = slaves[j];
+      }
+
+      if (typeWeak == typeStrong)
+         continue;
+
+      // Keep the pair of workers with the widest gap
+      if (weak == NULL || windows[typeWeak].score * windows[strong].score <
+                          windows[weak].score * windows[typeStrong].score) {
+         weak   = typeWeak;
+         strong = typeStrong;
+      }
+   }
+
+   if (weak == NULL ||
+       windows[weak].score >= REBALANCE_RATIO * windows[strong].score)
+      return;
+
+   SolverInterface * strongSolver = ((SequentialWorker *)strong)->solver;
+
+   log(1, "Portfolio: solver %d scores %f, solver %d scores %f\n",
+       ((SequentialWorker *)weak)->solver->id, windows[weak].score,
+       strongSolver->id, windows[strong].score);
+
+   weakest        = weak;
+   weakestStopped = false;
+
+   // SolverFactory::cloneSolver does not copy the MiniSat solvers
+   cloning = strongSolver->type != MINISAT;
+
+   // Interrupted under the lock, their next join is for the rebalancing
+   weakest->setInterrupt();
+   if (cloning) {
+      strongest = strong;
+      strongest->setInterrupt();
+   }
+}
+
+void
+Portfolio::respawn(WorkingStrategy * slave, SolverInterface * copy)
+{
+   SequentialWorker * worker = (SequentialWorker *)slave;
+   SolverInterface  * solver = copy ? copy : worker->solver;
+
+   solver->diversify(nextSeed++);
+
+   int vars = solver->getVariablesCount();
+   for (int var = 1; var <= vars; var++) {
+      solver->setPhase(var, rand() % 2 == 1);
+   }
+
+   if (copy) {
+      log(1, "Portfolio: solver %d is replaced by solver %d\n",
+          worker->solver->id, copy->id);
+
+      for (int i = 0; i < nSharers; i++) {
+         sharers[i]->replaceSolver(worker->solver, copy);
+      }
+
+      worker->solver->release();
+      worker->solver = copy;
+
+      nClones++;
+   } else {
+      log(1, "Portfolio: solver %d is rediversified\n", solver->id);
+
+      nRediversified++;
+   }
+
+   // The clone counts the conflicts of the solver it copies
+   windows[slave] = {solver->getStatistics(), getAbsoluteTime(), 0};
+
+   weakest        = NULL;
+   clone          = NULL;
+   cloning        = false;
+   weakestStopped = false;
+
+   slave->solve(cube);
+}
+
 void
 Portfolio::setInterrupt()
 {
+   if (period > 0) {
+      lock_guard<mutex> guard(lock);
+      cond.notify_one();
+   }
+
    for (size_t i = 0; i < slaves.size(); i++) {
       slaves[i]->setInterrupt();
    }
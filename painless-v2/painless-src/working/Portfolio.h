@@ -19,15 +19,48 @@
 
 #pragma once
 
+#include "../solvers/SolverInterface.h"
 #include "../utils/Parameters.h"
+#include "../utils/Threading.h"
 #include "../working/WorkingStrategy.h"
 
+#include <condition_variable>
+#include <map>
+#include <mutex>
+
 using namespace std;
 
+/// A worker scoring less than this ratio of the best score is rebalanced.
+#define REBALANCE_RATIO 0.5
+
+static void * mainMasterPortfolio(void * arg);
+
+/// Score of a worker over the current window of the rebalancing.
+struct PortfolioWindow
+{
+   /// Statistics of the solver and time at the start of the window.
+   SolvingStatistics stats;
+   double            start;
+
+   /// Conflicts per second divided by the average LBD of the learnt clauses,
+   /// negative if the solver reports no LBD.
+   double score;
+};
+
+/// Every slave solves the whole formula.
+///
+/// When a rebalancing period is given, the slaves must be sequential workers:
+/// the master thread scores them once per period, and the weakest worker, if
+/// far behind the strongest one, gets a clone of the strongest solver with a
+/// new diversification. The clone starts with the clauses learnt and imported
+/// by the strongest solver, and takes the place of the weakest one in the
+/// sharers. A solver that cannot be cloned is rediversified in place, keeping
+/// its clauses.
 class Portfolio : public WorkingStrategy
 {
 public:
-   Portfolio();
+   /// The period of the rebalancing is in second, 0 for a fixed portfolio.
+   Portfolio(double period = 0);
 
    ~Portfolio();
 
@@ -49,5 +82,48 @@ public:
    void bumpVariableActivity(int var, int times);
 
 protected:
+   friend void * mainMasterPortfolio(void * arg);
+
+   /// Score the workers, and interrupt the weakest one, and the strongest one
+   /// if it is cloned, when the weakest one is too far behind.
+   void rebalance();
+
+   /// Give a new solver, or a new diversification if NULL, to the weakest
+   /// worker and restart it.
+   void respawn(WorkingStrategy * slave, SolverInterface * copy);
+
    atomic<bool> strategyEnding;
+
+   double period;
+
+   Thread * master;
+
+   /// Protects the rebalancing state and the solvers of the workers, the
+   /// master waits on the condition for the next period.
+   mutex lock;
+   condition_variable cond;
+
+   vector<int> cube;
+
+   map<WorkingStrategy *, PortfolioWindow> windows;
+
+   /// Interrupted weakest worker, and the strongest one until it is cloned
+   /// for it.
+   WorkingStrategy * weakest;
+   WorkingStrategy * strongest;
+
+   /// The weakest worker gets a clone, else it is rediversified in place.
+   bool cloning;
+
+   /// The weakest worker is stopped, it waits for the clone.
+   bool weakestStopped;
+
+   /// Clone of the strongest solver waiting for the weakest worker to stop.
+   SolverInterface * clone;
+
+   /// Diversification of the next respawned solver.
+   int nextSeed;
+
+   int nClones;
+   int nRediversified;
 };